@@ -11,6 +11,11 @@
 #include <random>
 #include <thread>
 #include <mutex>
+#include <atomic>
+
+#include "Synchronized.h"
+#include "AdaptiveMutex.h"
+#include "Benchmark.h"
 
 /*
  * Item 7: Distinguish between () and {} when creating objects
@@ -301,21 +306,24 @@ public:
     }
 };
 
+// Mutex can be anything lockable, e.g. AdaptiveMutex for critical sections this short
+template <typename Mutex = std::mutex>
 class SafeCounter
 {
-    mutable std::mutex mutex;
+    mutable Mutex mutex;
     mutable int count;
 public:
     SafeCounter() : count { 0 } {}
 
     int getCount() const noexcept
     {
+        std::lock_guard<Mutex> lock { mutex };
         return count;
     }
 
     void increment() const noexcept
     {
-        std::lock_guard<std::mutex> lock { mutex };
+        std::lock_guard<Mutex> lock { mutex };
         ++count;
     }
 };
@@ -330,6 +338,54 @@ inline void threadFunc(T& counter, int iterations) noexcept
     }
 }
 
+// increments per second on one SafeCounter<Mutex> shared by numThreads threads
+template <typename Mutex>
+double counterThroughput(std::size_t numThreads, std::size_t incrementsPerThread)
+{
+    SafeCounter<Mutex> counter;
+    return measureThroughput(numThreads, incrementsPerThread, [&counter](std::size_t, std::size_t increments) {
+        for (std::size_t i = 0; i < increments; ++i)
+        {
+            counter.increment();
+        }
+    });
+}
+
+// read-mostly objects: every access goes through the Synchronized accessors
+template <typename Policy>
+using SyncedPair = Synchronized<IntPair, Policy>;
+
+struct ReadWriteRun
+{
+    double opsPerSecond;
+    std::size_t tornReads; // reads that saw the two halves of a write apart, zero for every policy
+};
+
+// operations on a shared IntPair when readPercent of the operations are reads
+template <typename Policy>
+ReadWriteRun readWriteThroughput(std::size_t numThreads, std::size_t opsPerThread, unsigned readPercent)
+{
+    SyncedPair<Policy> pair { 0, 0 };
+    std::atomic<std::size_t> tornReads { 0 };
+    auto opsPerSecond = measureThroughput(numThreads, opsPerThread,
+                                          [&pair, &tornReads, readPercent](std::size_t, std::size_t ops) {
+        std::size_t torn = 0;
+        for (std::size_t i = 0; i < ops; ++i)
+        {
+            if (i % 100 < readPercent)
+            {
+                torn += pair.read([](const IntPair& p) { return p.getFirst() != p.getSecond(); });
+            }
+            else
+            {
+                pair.write([](IntPair& p) { p = IntPair { p.getFirst() + 1, p.getSecond() + 1 }; });
+            }
+        }
+        tornReads += torn;
+    });
+    return ReadWriteRun { opsPerSecond, tornReads.load() };
+}
+
 /*
  * Item 17: Understand special member function generation
  */
@@ -9,6 +9,19 @@
 #include <sstream>
 #include <stdexcept>
 #include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+
+#include "Snapshot.h"
+#include "SlabAllocator.h"
+#include "UnrolledList.h"
+#include "ConcurrentList.h"
+#include "Benchmark.h"
 
 /*
  * Item 18: Use std::unique_ptr for exclusive-ownership resource management.
@@ -123,16 +136,228 @@ public:
 
     std::string getName() const noexcept { return name; }
     int getAge() const noexcept { return age; }
+
+    // Person can not be copied, a changed version is a new object; unlike create it lets
+    // bad_alloc through, a failed update must not take the process down
+    std::shared_ptr<Person> withAge(int newAge) const
+    {
+        return std::shared_ptr<Person> { new Person { name, newAge } };
+    }
 };
 
+// the same interface as Snapshot<T>, but every load takes a mutex to copy the shared_ptr
+template <typename T>
+class LockedSnapshot
+{
+public:
+    using Pin = std::shared_ptr<const T>;
+
+private:
+    mutable std::mutex mutex;
+    Pin current;
+
+public:
+    explicit LockedSnapshot(Pin initial) : current { std::move(initial) } {}
+
+    Pin load() const
+    {
+        std::lock_guard<std::mutex> lock { mutex };
+        return current;
+    }
+
+    template <typename F>
+    Pin update(F&& fn)
+    {
+        std::lock_guard<std::mutex> lock { mutex };
+        current = fn(*current);
+        return current;
+    }
+};
+
+// readers keep loading the published Person while a writer republishes it every millisecond,
+// returns reads per second
+template <typename Publisher>
+double personReadThroughput(std::size_t numReaders, std::size_t readsPerThread)
+{
+    using namespace std::literals;
+
+    Publisher published { Person::create("Alice", 30) };
+    std::atomic<bool> done { false };
+    std::thread writer([&published, &done]() {
+        while (!done.load(std::memory_order_relaxed))
+        {
+            published.update([](const Person& p) { return p.withAge(p.getAge() + 1); });
+            std::this_thread::sleep_for(1ms);
+        }
+    });
+
+    auto throughput = measureThroughput(numReaders, readsPerThread, [&published](std::size_t, std::size_t reads) {
+        int sink = 0;
+        for (std::size_t i = 0; i < reads; ++i)
+        {
+            auto pin = published.load();
+            sink += pin->getAge();
+        }
+        static_cast<void>(sink);
+    });
+
+    done = true;
+    writer.join();
+    return throughput;
+}
+
 /*
  * Item 20: Use std::weak_ptr for std::shared_ptr-like pointers that can dangle.
  */
 
-template<typename T>
+namespace detail
+{
+    template <typename Node, bool Indexed>
+    struct ListIndexLinks
+    {
+    };
+
+    template <typename Node>
+    struct ListIndexLinks<Node, true>
+    {
+        Node* left = nullptr;
+        Node* right = nullptr;
+        std::size_t weight = 1; // nodes in this subtree
+        std::uint32_t priority = 0;
+    };
+
+    template <typename Node, bool Indexed>
+    class ListIndex
+    {
+    public:
+        void clear() noexcept {}
+    };
+
+    // Implicit treap over the nodes of a list: in-order is list order, subtree weights turn a
+    // position into a path from the root and random priorities keep the expected depth logarithmic.
+    // The links are raw pointers, the list keeps owning its nodes.
+    template <typename Node>
+    class ListIndex<Node, true>
+    {
+        Node* root = nullptr;
+        std::uint32_t seed = 0x9e3779b9;
+
+        static std::size_t weightOf(const Node* n) noexcept { return n ? n->weight : 0; }
+
+        static void update(Node* n) noexcept { n->weight = 1 + weightOf(n->left) + weightOf(n->right); }
+
+        // the first k nodes end up under left, the rest under right
+        static void split(Node* n, std::size_t k, Node*& left, Node*& right) noexcept
+        {
+            if (n == nullptr)
+            {
+                left = right = nullptr;
+                return;
+            }
+            if (weightOf(n->left) < k)
+            {
+                split(n->right, k - weightOf(n->left) - 1, n->right, right);
+                left = n;
+            }
+            else
+            {
+                split(n->left, k, left, n->left);
+                right = n;
+            }
+            update(n);
+        }
+
+        static Node* merge(Node* a, Node* b) noexcept
+        {
+            if (a == nullptr || b == nullptr)
+            {
+                return a ? a : b;
+            }
+            if (a->priority > b->priority)
+            {
+                a->right = merge(a->right, b);
+                update(a);
+                return a;
+            }
+            b->left = merge(a, b->left);
+            update(b);
+            return b;
+        }
+
+        std::uint32_t nextPriority() noexcept
+        {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            return seed;
+        }
+
+    public:
+        ListIndex() = default;
+        ListIndex(ListIndex&& other) noexcept : root { std::exchange(other.root, nullptr) }, seed { other.seed } {}
+        ListIndex& operator=(ListIndex&& other) noexcept
+        {
+            root = std::exchange(other.root, nullptr);
+            return *this;
+        }
+
+        void insert(std::size_t pos, Node* node) noexcept
+        {
+            node->left = node->right = nullptr;
+            node->weight = 1;
+            node->priority = nextPriority();
+            Node* left;
+            Node* right;
+            split(root, pos, left, right);
+            root = merge(merge(left, node), right);
+        }
+
+        Node* remove(std::size_t pos) noexcept
+        {
+            Node* left;
+            Node* middle;
+            Node* right;
+            split(root, pos, left, right);
+            split(right, 1, middle, right);
+            root = merge(left, right);
+            return middle;
+        }
+
+        Node* at(std::size_t pos) const noexcept
+        {
+            auto n = root;
+            while (true)
+            {
+                auto leftWeight = weightOf(n->left);
+                if (pos == leftWeight)
+                {
+                    return n;
+                }
+                if (pos < leftWeight)
+                {
+                    n = n->left;
+                }
+                else
+                {
+                    pos -= leftWeight + 1;
+                    n = n->right;
+                }
+            }
+        }
+
+        void clear() noexcept { root = nullptr; }
+    };
+}
+
+// Nodes come from std::allocate_shared with Alloc, so node and control block share one
+// allocation and every node keeps a copy of the allocator it was made with. With a
+// SlabAllocator the nodes are carved from a SlabPool instead of one heap call each.
+// The size is cached. Without an index, positional access walks from the nearer end;
+// with Indexed a treap over the nodes makes insert, remove and operator[] by position O(log n).
+template<typename T, typename Alloc = std::allocator<T>, bool Indexed = false>
 class LinkedList
 {
-    struct Node
+    struct Node : detail::ListIndexLinks<Node, Indexed>
     {
         std::shared_ptr<Node> next;
         std::weak_ptr<Node> prev;
@@ -143,100 +368,170 @@ class LinkedList
 
     std::shared_ptr<Node> head;
     std::shared_ptr<Node> tail;
+    std::size_t count = 0;
+    [[no_unique_address]] detail::ListIndex<Node, Indexed> index;
+    [[no_unique_address]] Alloc alloc;
 
 public:
-    LinkedList() : head { nullptr }, tail { nullptr } {}
-    LinkedList(std::initializer_list<T> initList) : LinkedList {}
+    LinkedList() : head { nullptr }, tail { nullptr }, alloc {} {}
+    explicit LinkedList(const Alloc& alloc) : head { nullptr }, tail { nullptr }, alloc { alloc } {}
+    LinkedList(std::initializer_list<T> initList, const Alloc& alloc = Alloc()) : LinkedList { alloc }
     {
         for (auto value : initList)
         {
             push_back(value);
         }
     }
-    LinkedList(const LinkedList& other) : LinkedList()
+    LinkedList(const LinkedList& other)
+        : LinkedList(std::allocator_traits<Alloc>::select_on_container_copy_construction(other.alloc))
     {
         for (auto node = other.head; node != nullptr; node = node->next)
         {
             push_back(node->value);
         }
     }
-    LinkedList(LinkedList&& other) : head(std::move(other.head)), tail(std::move(other.tail)) {}
+    LinkedList(LinkedList&& other)
+        : head(std::move(other.head)), tail(std::move(other.tail)), count(std::exchange(other.count, 0)),
+          index(std::move(other.index)), alloc(other.alloc)
+    {
+    }
     LinkedList& operator=(const LinkedList& other)
     {
         if (this != &other)
         {
-            LinkedList temp(other);
+            LinkedList temp(alloc);
+            for (auto node = other.head; node != nullptr; node = node->next)
+            {
+                temp.push_back(node->value);
+            }
             std::swap(head, temp.head);
             std::swap(tail, temp.tail);
+            std::swap(count, temp.count);
+            std::swap(index, temp.index);
         }
         return *this;
     }
+    // nodes carry their own allocator, so they can change lists whatever the lists' allocators
     LinkedList& operator=(LinkedList&& other)
     {
         if (this != &other)
         {
+            erase();
             head = std::move(other.head);
             tail = std::move(other.tail);
+            count = std::exchange(other.count, 0);
+            index = std::move(other.index);
         }
         return *this;
     }
+    ~LinkedList()
+    {
+        erase();
+    }
 
-    class Iterator
+    // Borrowed raw pointers into the list, valid until their node is removed; stepping forward
+    // is plain pointer chasing. Stepping back goes through the node's weak prev link, so it
+    // still pays for a lock(). end() knows its list to step back to the tail.
+    template <bool Const>
+    class BasicIterator
     {
-        std::weak_ptr<Node> current;
+        using NodePtr = std::conditional_t<Const, const Node*, Node*>;
+
+        const LinkedList* list = nullptr;
+        NodePtr current = nullptr;
+
+        friend class LinkedList;
+
+        BasicIterator(const LinkedList* l, NodePtr node) noexcept : list { l }, current { node } {}
 
     public:
-        explicit Iterator(const std::shared_ptr<Node>& node) : current { node } {}
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+        using reference = std::conditional_t<Const, const T&, T&>;
+
+        BasicIterator() noexcept = default;
+
+        template <bool OtherConst>
+            requires(Const && !OtherConst)
+        BasicIterator(const BasicIterator<OtherConst>& other) noexcept : list { other.list }, current { other.current }
+        {
+        }
 
-        T& operator*() const noexcept
+        reference operator*() const noexcept
         {
-            return current.lock()->value;
+            return current->value;
         }
 
-        T& operator->() const noexcept
+        pointer operator->() const noexcept
         {
-            return &current.lock()->value;
+            return &current->value;
         }
 
-        Iterator& operator++() noexcept
+        BasicIterator& operator++() noexcept
         {
-            current = current.lock()->next;
+            current = current->next.get();
             return *this;
         }
 
-        Iterator operator++(int) noexcept
+        BasicIterator operator++(int) noexcept
         {
-            Iterator temp(*this);
+            BasicIterator temp(*this);
             ++(*this);
             return temp;
         }
 
-        inline operator bool() const noexcept { return !current.expired(); }
+        BasicIterator& operator--() noexcept
+        {
+            current = current ? current->prev.lock().get() : list->tail.get();
+            return *this;
+        }
 
-        bool operator==(const Iterator& other) const noexcept
+        BasicIterator operator--(int) noexcept
         {
-            return current == other.current;
+            BasicIterator temp(*this);
+            --(*this);
+            return temp;
         }
 
-        bool operator!=(const Iterator& other) const noexcept
+        explicit operator bool() const noexcept { return current != nullptr; }
+
+        bool operator==(const BasicIterator& other) const noexcept
         {
-            return !(*this == other);
+            return current == other.current;
         }
+
+        template <bool>
+        friend class BasicIterator;
     };
 
-    Iterator begin() const noexcept
-    {
-        return Iterator { head };
-    }
+    using iterator = BasicIterator<false>;
+    using const_iterator = BasicIterator<true>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+    using Iterator = iterator;
 
-    Iterator end() const noexcept
-    {
-        return Iterator { nullptr };
-    }
+    iterator begin() noexcept { return iterator { this, head.get() }; }
+    iterator end() noexcept { return iterator { this, nullptr }; }
+    const_iterator begin() const noexcept { return const_iterator { this, head.get() }; }
+    const_iterator end() const noexcept { return const_iterator { this, nullptr }; }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    reverse_iterator rbegin() noexcept { return reverse_iterator { end() }; }
+    reverse_iterator rend() noexcept { return reverse_iterator { begin() }; }
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator { end() }; }
+    const_reverse_iterator rend() const noexcept { return const_reverse_iterator { begin() }; }
 
     LinkedList& push_back(const T& value) noexcept
     {
-        auto newNode = std::make_shared<Node>(value);
+        auto newNode = std::allocate_shared<Node>(alloc, value);
+        if constexpr (Indexed)
+        {
+            index.insert(count, newNode.get());
+        }
+        ++count;
         if (head == nullptr)
         {
             head = newNode;
@@ -252,7 +547,12 @@ public:
     }
     LinkedList& push_front(const T& value) noexcept
     {
-        auto newNode = std::make_shared<Node>(value);
+        auto newNode = std::allocate_shared<Node>(alloc, value);
+        if constexpr (Indexed)
+        {
+            index.insert(0, newNode.get());
+        }
+        ++count;
         if (head == nullptr)
         {
             head = newNode;
@@ -272,6 +572,11 @@ public:
         {
             throw std::runtime_error { "pop from empty list" };
         }
+        if constexpr (Indexed)
+        {
+            index.remove(count - 1);
+        }
+        --count;
         tail = tail->prev.lock();
         if (tail != nullptr)
         {
@@ -289,6 +594,11 @@ public:
         {
             throw std::runtime_error("pop from empty list");
         }
+        if constexpr (Indexed)
+        {
+            index.remove(0);
+        }
+        --count;
         head = head->next;
         if (head != nullptr)
         {
@@ -307,26 +617,28 @@ public:
             return push_front(value);
             return *this;
         }
-        if (pos == size())
+        if (pos == count)
         {
             return push_back(value);
             return *this;
         }
-        else if (pos > size())
+        else if (pos > count)
         {
             throw std::out_of_range("index out of range");
         }
 
-        auto newNode = std::make_shared<Node>(value);
-        auto node = head;
-        for (std::size_t i = 0; i < pos; ++i)
+        auto newNode = std::allocate_shared<Node>(alloc, value);
+        auto node = nodeAt(pos);
+        auto prevNode = node->prev.lock();
+        newNode->next = std::move(prevNode->next);
+        newNode->prev = prevNode;
+        prevNode->next = newNode;
+        node->prev = newNode;
+        if constexpr (Indexed)
         {
-            node = node->next;
+            index.insert(pos, newNode.get());
         }
-        newNode->next = node;
-        newNode->prev = node->prev;
-        node->prev.lock()->next = newNode;
-        node->prev = newNode;
+        ++count;
 
         return *this;
     }
@@ -337,35 +649,37 @@ public:
             return pop_front();
             return *this;
         }
-        if (pos == size() - 1)
+        if (pos >= count)
         {
-            return pop_back();
-            return *this;
+            throw std::out_of_range("index out of range");
         }
-        if (pos >= size())
+        if (pos == count - 1)
         {
-            throw std::out_of_range("index out of range");
+            return pop_back();
+            return *this;
         }
 
-        auto node = head;
-        for (std::size_t i = 0; i < pos; ++i)
+        auto node = nodeAt(pos);
+        if constexpr (Indexed)
         {
-            node = node->next;
+            index.remove(pos);
         }
-        node->prev.lock()->next = node->next;
-        node->next->prev = node->prev;
+        --count;
+        auto prevNode = node->prev.lock();
+        node->next->prev = prevNode;
+        // releases the node
+        prevNode->next = std::move(node->next);
 
         return *this;
     }
 
+    // unchecked like std::vector's
+    T& operator[](std::size_t pos) noexcept { return nodeAt(pos)->value; }
+    const T& operator[](std::size_t pos) const noexcept { return nodeAt(pos)->value; }
+
     std::size_t size() const noexcept
     {
-        std::size_t size = 0;
-        for (auto node = head; node != nullptr; node = node->next)
-        {
-            ++size;
-        }
-        return size;
+        return count;
     }
 
     bool empty() const noexcept
@@ -373,16 +687,53 @@ public:
         return head == nullptr;
     }
 
+    // unlinks node by node, letting the chain of next pointers destroy itself would recurse
+    // once per element
     LinkedList& erase() noexcept
     {
-        head.reset();
+        index.clear();
+        count = 0;
         tail.reset();
+        while (head != nullptr)
+        {
+            head = std::move(head->next);
+        }
         return *this;
     }
+
+private:
+    Node* nodeAt(std::size_t pos) const noexcept
+    {
+        if constexpr (Indexed)
+        {
+            return index.at(pos);
+        }
+        else if (pos < count / 2)
+        {
+            auto node = head.get();
+            for (std::size_t i = 0; i < pos; ++i)
+            {
+                node = node->next.get();
+            }
+            return node;
+        }
+        else
+        {
+            auto node = tail;
+            for (std::size_t i = count - 1; i > pos; --i)
+            {
+                node = node->prev.lock();
+            }
+            return node.get();
+        }
+    }
 };
 
-template <typename T>
-inline bool operator==(const LinkedList<T>& lhs, const LinkedList<T>& rhs) noexcept
+template <typename T, typename Alloc = std::allocator<T>>
+using IndexedLinkedList = LinkedList<T, Alloc, true>;
+
+template <typename T, typename A, bool I, typename B, bool J>
+inline bool operator==(const LinkedList<T, A, I>& lhs, const LinkedList<T, B, J>& rhs) noexcept
 {
     if (lhs.size() != rhs.size())
     {
@@ -402,12 +753,242 @@ inline bool operator==(const LinkedList<T>& lhs, const LinkedList<T>& rhs) noexc
     return true;
 }
 
-template <typename T>
-inline bool operator!=(const LinkedList<T>& lhs, const LinkedList<T>& rhs) noexcept
+template <typename T, typename A, bool I, typename B, bool J>
+inline bool operator!=(const LinkedList<T, A, I>& lhs, const LinkedList<T, B, J>& rhs) noexcept
 {
     return !(lhs == rhs);
 }
 
+struct ListBenchmark
+{
+    double opsPerSecond;    // push_backs and pop_fronts
+    double bytesPerElement; // heap memory behind each element with the list full
+};
+
+namespace detail
+{
+    // push_backs numElements ints, then pop_fronts them all, returns operations per second
+    template <typename List>
+    double fillAndDrain(List& list, std::size_t numElements)
+    {
+        auto begin = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < numElements; ++i)
+        {
+            list.push_back(static_cast<int>(i));
+        }
+        while (!list.empty())
+        {
+            list.pop_front();
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        return static_cast<double>(2 * numElements) / elapsed.count();
+    }
+}
+
+// one allocation per node as with make_shared, bytes include malloc's header and rounding,
+// which the pool does not pay per node
+inline ListBenchmark linkedListBenchmark(std::size_t numElements)
+{
+    AllocationCounters counters;
+    LinkedList<int, CountingAllocator<int>> list { CountingAllocator<int> { counters } };
+    auto ops = detail::fillAndDrain(list, numElements);
+    return ListBenchmark { ops, static_cast<double>(counters.peakFootprintBytes) / static_cast<double>(numElements) };
+}
+
+// nodes from a SlabPool, bytes are the slabs the pool had to take
+inline ListBenchmark pooledLinkedListBenchmark(std::size_t numElements)
+{
+    SlabPool pool;
+    LinkedList<int, SlabAllocator<int>> list { SlabAllocator<int> { pool } };
+    auto ops = detail::fillAndDrain(list, numElements);
+    return ListBenchmark { ops, static_cast<double>(pool.reservedBytes()) / static_cast<double>(numElements) };
+}
+
+namespace detail
+{
+    // sums the list passes times, returns elements visited per second
+    template <typename List>
+    double scanPasses(const List& list, std::size_t passes)
+    {
+        long long sum = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (std::size_t pass = 0; pass < passes; ++pass)
+        {
+            for (const auto& value : list)
+            {
+                sum += value;
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+        static_cast<void>(sum);
+        return static_cast<double>(passes * list.size()) / elapsed.count();
+    }
+}
+
+// full scans over a list of numElements ints, one node per element
+inline ListBenchmark linkedListScanBenchmark(std::size_t numElements, std::size_t passes)
+{
+    AllocationCounters counters;
+    LinkedList<int, CountingAllocator<int>> list { CountingAllocator<int> { counters } };
+    for (std::size_t i = 0; i < numElements; ++i)
+    {
+        list.push_back(static_cast<int>(i));
+    }
+    auto elementsPerSecond = detail::scanPasses(list, passes);
+    return ListBenchmark { elementsPerSecond, static_cast<double>(counters.bytes) / static_cast<double>(numElements) };
+}
+
+// the same with UnrolledList's nodes of two cache lines
+inline ListBenchmark unrolledListScanBenchmark(std::size_t numElements, std::size_t passes)
+{
+    UnrolledList<int> list;
+    for (std::size_t i = 0; i < numElements; ++i)
+    {
+        list.push_back(static_cast<int>(i));
+    }
+    auto elementsPerSecond = detail::scanPasses(list, passes);
+    return ListBenchmark { elementsPerSecond, static_cast<double>(list.memoryBytes()) / static_cast<double>(numElements) };
+}
+
+// the baseline for ConcurrentList: a sorted LinkedList behind one mutex
+template <typename T>
+class LockedListSet
+{
+    mutable std::mutex mutex;
+    LinkedList<T> list;
+
+    // position of the first element not less than value and whether it is value
+    std::pair<std::size_t, bool> lowerBound(const T& value) const
+    {
+        std::size_t pos = 0;
+        for (auto it = list.begin(); it; ++it, ++pos)
+        {
+            if (!(*it < value))
+            {
+                return { pos, !(value < *it) };
+            }
+        }
+        return { pos, false };
+    }
+
+public:
+    bool insert(const T& value)
+    {
+        std::lock_guard<std::mutex> lock { mutex };
+        auto [pos, found] = lowerBound(value);
+        if (!found)
+        {
+            list.insert(value, pos);
+        }
+        return !found;
+    }
+
+    bool erase(const T& value)
+    {
+        std::lock_guard<std::mutex> lock { mutex };
+        auto [pos, found] = lowerBound(value);
+        if (found)
+        {
+            list.remove(pos);
+        }
+        return found;
+    }
+
+    bool contains(const T& value) const
+    {
+        std::lock_guard<std::mutex> lock { mutex };
+        return lowerBound(value).second;
+    }
+
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> lock { mutex };
+        return list.size();
+    }
+};
+
+// threads run a mix of 80% contains, 10% insert and 10% erase over keys in [0, keyRange) on a set
+// that starts half full, returns operations per second
+template <typename Set>
+double orderedSetThroughput(std::size_t numThreads, std::size_t opsPerThread, int keyRange = 256)
+{
+    Set set;
+    for (int key = 0; key < keyRange; key += 2)
+    {
+        set.insert(key);
+    }
+
+    return measureThroughput(numThreads, opsPerThread, [&set, keyRange](std::size_t threadIndex, std::size_t ops) {
+        std::uint64_t state = 0x9e3779b97f4a7c15ull * (threadIndex + 1);
+        std::size_t hits = 0;
+        for (std::size_t i = 0; i < ops; ++i)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            auto key = static_cast<int>(state % static_cast<std::uint64_t>(keyRange));
+            switch ((state >> 32) % 10)
+            {
+            case 0:
+                hits += set.insert(key);
+                break;
+            case 1:
+                hits += set.erase(key);
+                break;
+            default:
+                hits += set.contains(key);
+                break;
+            }
+        }
+        static_cast<void>(hits);
+    });
+}
+
+namespace detail
+{
+    // alternates inserts and removes at pseudo-random positions, the same ones for every list type
+    template <typename List>
+    void positionalEdits(List& list, std::size_t numEdits)
+    {
+        std::uint64_t state = 88172645463325252ull;
+        auto nextPosition = [&state](std::size_t bound) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return static_cast<std::size_t>(state % bound);
+        };
+
+        for (std::size_t i = 0; i < numEdits; ++i)
+        {
+            if (i % 2 == 0)
+            {
+                list.insert(static_cast<int>(i), nextPosition(list.size() + 1));
+            }
+            else
+            {
+                list.remove(nextPosition(list.size()));
+            }
+        }
+    }
+}
+
+// positionalEdits on a list holding numElements, returns edits per second
+template <typename List>
+double positionalEditThroughput(std::size_t numElements, std::size_t numEdits)
+{
+    List list;
+    for (std::size_t i = 0; i < numElements; ++i)
+    {
+        list.push_back(static_cast<int>(i));
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    detail::positionalEdits(list, numEdits);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+    return static_cast<double>(numEdits) / elapsed.count();
+}
+
 /*
  * Item 22: When using the Pimpl Idiom, define special member functions in the implementation file.
  */
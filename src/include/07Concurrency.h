@@ -4,6 +4,31 @@
 #include <future>
 #include <chrono>
 #include <vector>
+#include <string>
+#include <memory>
+#include <exception>
+#include <iterator>
+#include <optional>
+#include <cstdint>
+#include <latch>
+
+#include "ThreadPool.h"
+#include "ParallelFor.h"
+#include "StripedCounter.h"
+#include "MPMCQueue.h"
+#include "SPSCQueue.h"
+#include "Channel.h"
+#include "Task.h"
+#include "Lazy.h"
+#include "Future.h"
+#include "LightFuture.h"
+#include "PriorityExecutor.h"
+#include "EpochReclamation.h"
+#include "TaskGraph.h"
+#include "TimerWheel.h"
+#include "StartGate.h"
+#include "ThreadPlacement.h"
+#include "Benchmark.h"
 
 /*
  * Item 35: Prefer task-based programming to thread-based
@@ -19,6 +44,12 @@ int add(int a, int b)
     return a + b;
 }
 
+// delayed counterparts of addSleep: a pending delay is a timer entry, not a sleeping thread
+Future<int> addAfter(TimerWheel& timer, std::chrono::milliseconds delay, int a, int b)
+{
+    return timer.after(delay).then([a, b]() { return add(a, b); });
+}
+
 template <typename T>
 void createTasksThread(std::size_t numTasks, T task) 
 {
@@ -40,12 +71,136 @@ std::vector<int> createTasksAsync(std::size_t numTasks, T task)
     std::vector<std::future<int>> futures;
     for (std::size_t i = 0; i < numTasks; ++i) 
     {
-        futures.emplace_back(std::async(task, i, i));
+        futures.emplace_back(std::async(instrumentTask(task), i, i));
     }
     std::vector<int> results;
     for (auto& f : futures) 
     {
-        results.push_back(f.get());
+        results.push_back(timeBlocking([&f]() { return f.get(); }));
+    }
+    return results;
+}
+
+// same as above, but the tasks share a fixed set of pool workers instead of a thread each
+template <typename T>
+std::vector<int> createTasksAsync(std::size_t numTasks, T task, ThreadPool& pool)
+{
+    std::vector<std::future<int>> futures;
+    futures.reserve(numTasks);
+    for (std::size_t i = 0; i < numTasks; ++i) 
+    {
+        futures.emplace_back(pool.submit(task, i, i));
+    }
+    std::vector<int> results;
+    results.reserve(numTasks);
+    for (auto& f : futures) 
+    {
+        results.push_back(timeBlocking([&f]() { return f.get(); }));
+    }
+    return results;
+}
+
+// same as above with pooled LightFutures: no heap allocation per task once the pools are warm
+template <typename T>
+std::vector<int> createTasksAsyncLight(std::size_t numTasks, T task, ThreadPool& pool)
+{
+    std::vector<LightFuture<int>> futures;
+    futures.reserve(numTasks);
+    for (std::size_t i = 0; i < numTasks; ++i) 
+    {
+        futures.emplace_back(asyncLight(pool, instrumentTask(task), i, i));
+    }
+    std::vector<int> results;
+    results.reserve(numTasks);
+    for (auto& f : futures) 
+    {
+        results.push_back(timeBlocking([&f]() { return f.get(); }));
+    }
+    return results;
+}
+
+// average time from set_value on a pool worker until get() returns on this thread,
+// Promise is either std::promise<int> or LightPromise<int>
+template <template <typename> class Promise>
+std::chrono::nanoseconds completionLatency(ThreadPool& pool, std::size_t rounds)
+{
+    std::chrono::nanoseconds total { 0 };
+    for (std::size_t i = 0; i < rounds; ++i)
+    {
+        Promise<int> promise;
+        auto future = promise.get_future();
+        std::chrono::steady_clock::time_point sent;
+        pool.post([promise = std::move(promise), &sent, i]() mutable {
+            sent = std::chrono::steady_clock::now();
+            promise.set_value(static_cast<int>(i));
+        });
+        future.get();
+        total += std::chrono::steady_clock::now() - sent;
+    }
+    return total / std::max<std::size_t>(rounds, 1);
+}
+
+// no head-of-line blocking: the results are collected as the tasks finish, in whatever order
+template <typename T>
+Future<std::vector<int>> createTasksWhenAll(std::size_t numTasks, T task, ThreadPool& pool)
+{
+    std::vector<Future<int>> futures;
+    futures.reserve(numTasks);
+    for (std::size_t i = 0; i < numTasks; ++i) 
+    {
+        futures.emplace_back(asyncOn(pool, task, i, i));
+    }
+    return when_all(futures);
+}
+
+// one chunk of indices per pool task and a single preallocated result vector
+template <typename T>
+std::vector<int> createTasksParallel(std::size_t numTasks, T task, ThreadPool& pool)
+{
+    return parallel_transform(pool, 0, numTasks, 0, [&task](std::size_t i) -> int {
+        return task(i, i);
+    });
+}
+
+// indices are handed to a fixed set of workers through one bounded lock-free queue
+template <typename T>
+std::vector<int> createTasksQueued(std::size_t numTasks, T task, std::size_t numWorkers)
+{
+    constexpr std::size_t batchSize = 64;
+    constexpr auto noMoreTasks = static_cast<std::size_t>(-1);
+
+    MPMCQueue<std::size_t> queue { 1024 };
+    std::vector<int> results(numTasks);
+
+    std::vector<std::thread> workers;
+    for (std::size_t w = 0; w < numWorkers; ++w)
+    {
+        workers.emplace_back([&queue, &results, &task]() {
+            for (auto i = queue.pop(); i != noMoreTasks; i = queue.pop())
+            {
+                results[i] = task(i, i);
+            }
+        });
+    }
+
+    std::vector<std::size_t> batch;
+    for (std::size_t i = 0; i < numTasks; i += batchSize)
+    {
+        batch.clear();
+        for (auto j = i; j < std::min(i + batchSize, numTasks); ++j)
+        {
+            batch.push_back(j);
+        }
+        queue.push_n(batch.begin(), batch.size());
+    }
+    for (std::size_t w = 0; w < numWorkers; ++w)
+    {
+        queue.push(noMoreTasks);
+    }
+
+    for (auto& t : workers)
+    {
+        t.join();
     }
     return results;
 }
@@ -60,10 +215,24 @@ template<typename F, typename... Ts>
 inline auto asyncTask(F&& f, Ts&&... params)
 {
     return std::async(std::launch::async,
-                      std::forward<F>(f),
+                      instrumentTask(std::forward<F>(f)),
                       std::forward<Ts>(params)...);
 }
 
+// on a pool the task runs on one of its workers and the result comes back through a LightFuture
+template<typename F, typename... Ts>
+inline auto asyncTask(ThreadPool& pool, F&& f, Ts&&... params)
+{
+    return asyncLight(pool, instrumentTask(std::forward<F>(f)), std::forward<Ts>(params)...);
+}
+
+// latency-sensitive work goes in a higher lane or with a deadline, batch work in a lower one
+template<typename F, typename... Ts>
+inline auto asyncTask(PriorityExecutor& executor, TaskOptions options, F&& f, Ts&&... params)
+{
+    return executor.submit(options, instrumentTask(std::forward<F>(f)), std::forward<Ts>(params)...);
+}
+
 template<typename F, typename... Ts>
 inline auto deferredTask(F&& f, Ts&&... params)
 {
@@ -72,6 +241,16 @@ inline auto deferredTask(F&& f, Ts&&... params)
                       std::forward<Ts>(params)...);
 }
 
+// like deferredTask, computed by whoever asks first, but the result can be read any number
+// of times from any number of threads, and there is no shared state to allocate
+template<typename F, typename... Ts>
+inline auto lazyTask(F&& f, Ts&&... params)
+{
+    return makeLazy([f = std::forward<F>(f), ... params = std::forward<Ts>(params)]() mutable {
+        return std::invoke(f, params...);
+    });
+}
+
 template<typename T>
 LaunchPolicy testLaunchPolicy(T&& task)
 {
@@ -82,14 +261,33 @@ LaunchPolicy testLaunchPolicy(T&& task)
     } 
     else 
     { 
-        while (task.wait_for(100ms) != std::future_status::ready) 
-        {
-            // do something else
-        }
+        // block until ready instead of polling with wait_for(100ms),
+        // with Future<T> a continuation (.then) avoids blocking at all
+        task.wait();
         return LaunchPolicy::Async;
     }
 }
 
+// coroutine counterparts: dependent steps suspend instead of holding a thread while they wait
+Task<int> addOn(ThreadPool& pool, int a, int b)
+{
+    co_await schedule_on(pool);
+    co_return add(a, b);
+}
+
+Task<int> addChainOn(ThreadPool& pool, int a, int b)
+{
+    auto sum = co_await addOn(pool, a, b);
+    co_return co_await addOn(pool, sum, b);
+}
+
+Task<int> addAfterOn(TimerWheel& timer, ThreadPool& pool, std::chrono::milliseconds delay, int a, int b)
+{
+    co_await timer.sleep(delay);
+    co_await schedule_on(pool);
+    co_return add(a, b);
+}
+
 /*
  * Item 37: Make std::threads unjoinable on all paths
  */
@@ -108,7 +306,7 @@ public:
         {
             if (action == DtorAction::Join) 
             {
-                t.join();
+                timeBlocking([this]() { t.join(); });
             } 
             else 
             {
@@ -125,6 +323,345 @@ public:
     ThreadRAII& operator=(ThreadRAII&&) = default;
 };
 
+struct WorkerOptions
+{
+    std::string name = "worker";           // the threads are called name-0, name-1, ...
+    Placement placement = Placement::None;
+    std::vector<unsigned> cpus = {};       // one CPU per worker (wrapping around), overrides placement
+};
+
+// Workers on ThreadRAII that name and pin themselves before they run fn(index), so none of them
+// starts out on the wrong core. The constructor returns once every worker is set up.
+// Pinning is best effort: where the platform refuses, the worker runs unpinned and isPinned says so.
+class WorkerGroup
+{
+    std::vector<unsigned> cpus;
+    std::vector<char> pinned;
+    std::vector<ThreadRAII> threads;
+
+public:
+    template <typename F>
+    WorkerGroup(std::size_t numThreads, WorkerOptions options, F fn)
+        : pinned(numThreads, 0)
+    {
+        if (options.cpus.empty())
+        {
+            cpus = placeThreads(usableCpus(), numThreads, options.placement);
+        }
+        else
+        {
+            for (std::size_t i = 0; i < numThreads; ++i)
+            {
+                cpus.push_back(options.cpus[i % options.cpus.size()]);
+            }
+        }
+
+        std::latch ready { static_cast<std::ptrdiff_t>(numThreads) };
+        threads.reserve(numThreads);
+        for (std::size_t i = 0; i < numThreads; ++i)
+        {
+            threads.emplace_back(std::thread { [this, i, &ready, name = options.name + "-" + std::to_string(i), fn]() mutable {
+                setCurrentThreadName(name);
+                if (i < cpus.size())
+                {
+                    pinned[i] = pinCurrentThread({ cpus[i] });
+                }
+                ready.count_down();
+                fn(i);
+            } }, DtorAction::Join);
+        }
+        ready.wait();
+    }
+
+    std::size_t size() const noexcept { return threads.size(); }
+
+    // the CPU worker i was placed on, nullopt if it was left to the scheduler
+    std::optional<unsigned> cpuOf(std::size_t i) const
+    {
+        return i < cpus.size() ? std::optional<unsigned> { cpus[i] } : std::nullopt;
+    }
+
+    bool isPinned(std::size_t i) const { return pinned[i] != 0; }
+
+    void join()
+    {
+        for (auto& t : threads)
+        {
+            if (t.get().joinable())
+            {
+                t.get().join();
+            }
+        }
+    }
+};
+
+struct CacheResidentRun
+{
+    double passesPerSecond; // over all workers
+    std::uint64_t checksum; // depends on the work only, never on where it ran
+};
+
+// Every worker keeps rewriting its own block, small enough to stay in L1/L2, for the given number
+// of passes. A worker that migrates leaves its warm cache behind, so placement shows up once there
+// are a few cores and some background load.
+inline CacheResidentRun cacheResidentThroughput(std::size_t numThreads, Placement placement, std::size_t passes,
+                                      std::size_t blockBytes = 32 * 1024)
+{
+    StartGate gate { numThreads };
+    std::vector<std::uint64_t> sums(numThreads);
+    std::chrono::steady_clock::time_point begin;
+    {
+        WorkerGroup workers { numThreads, WorkerOptions { "cache", placement }, [&](std::size_t i) {
+            std::vector<std::uint64_t> block(blockBytes / sizeof(std::uint64_t), i + 1);
+            gate.arriveAndWait();
+            std::uint64_t sum = 0;
+            for (std::size_t pass = 0; pass < passes; ++pass)
+            {
+                for (auto& value : block)
+                {
+                    sum += value;
+                    value = sum ^ pass;
+                }
+            }
+            sums[i] = sum;
+        } };
+        gate.waitUntilReady();
+        begin = std::chrono::steady_clock::now();
+        gate.open();
+        workers.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+    std::uint64_t checksum = 0;
+    for (auto sum : sums)
+    {
+        checksum += sum;
+    }
+    return CacheResidentRun { static_cast<double>(numThreads * passes) / elapsed.count(), checksum };
+}
+
+// Stages of a streaming pipeline, each on its own ThreadRAII, linked by SPSC rings.
+// Items move through in batches; a full ring holds the stage before it back.
+namespace detail
+{
+    struct PipelineStages
+    {
+        std::size_t capacity;
+        std::size_t batchSize;
+        std::vector<std::shared_ptr<void>> queues;
+        std::atomic<bool> failed { false };
+        std::exception_ptr error;
+        // declared last, so the threads are joined before the queues go away
+        std::vector<ThreadRAII> threads;
+
+        template <typename T>
+        SPSCQueue<T>* addQueue()
+        {
+            auto queue = std::make_shared<SPSCQueue<T>>(capacity);
+            queues.push_back(queue);
+            return queue.get();
+        }
+
+        // the first exception stops all processing, the rest of the input is drained and dropped
+        template <typename A, typename Emit>
+        void runStage(SPSCQueue<A>& in, Emit emit)
+        {
+            std::vector<A> batch;
+            batch.reserve(batchSize);
+            while (in.pop_n(std::back_inserter(batch), batchSize) > 0)
+            {
+                if (!failed.load(std::memory_order_relaxed))
+                {
+                    try
+                    {
+                        emit(batch);
+                    }
+                    catch (...)
+                    {
+                        if (!failed.exchange(true))
+                        {
+                            error = std::current_exception();
+                        }
+                    }
+                }
+                batch.clear();
+            }
+        }
+    };
+}
+
+template <typename In>
+class Pipeline
+{
+    SPSCQueue<In>* input;
+    std::unique_ptr<detail::PipelineStages> stages;
+    bool closed = false;
+
+public:
+    Pipeline(SPSCQueue<In>* in, std::unique_ptr<detail::PipelineStages> s) noexcept
+        : input { in }, stages { std::move(s) }
+    {
+    }
+
+    Pipeline(Pipeline&&) noexcept = default;
+    Pipeline& operator=(Pipeline&&) = delete;
+
+    // pending items are still processed, an exception of a stage is dropped (use finish to see it)
+    ~Pipeline()
+    {
+        if (stages)
+        {
+            close();
+        }
+    }
+
+    // the input side is single-producer: one thread at a time may push
+    void push(In item) { input->push(std::move(item)); }
+
+    template <typename It>
+    void push_n(It first, std::size_t count) { input->push_n(first, count); }
+
+    void close() noexcept
+    {
+        if (!std::exchange(closed, true))
+        {
+            input->close();
+        }
+    }
+
+    // closes the input, waits until every item went through and rethrows the first stage exception
+    void finish()
+    {
+        close();
+        stages->threads.clear();
+        if (stages->error)
+        {
+            std::rethrow_exception(stages->error);
+        }
+    }
+};
+
+template <typename In, typename Out>
+class PipelineBuilder
+{
+    SPSCQueue<In>* input;
+    SPSCQueue<Out>* output;
+    std::unique_ptr<detail::PipelineStages> stages;
+
+    template <typename A, typename B>
+    friend class PipelineBuilder;
+
+public:
+    PipelineBuilder(SPSCQueue<In>* in, SPSCQueue<Out>* out, std::unique_ptr<detail::PipelineStages> s) noexcept
+        : input { in }, output { out }, stages { std::move(s) }
+    {
+    }
+
+    PipelineBuilder(PipelineBuilder&&) noexcept = default;
+    PipelineBuilder& operator=(PipelineBuilder&&) = delete;
+
+    // a pipeline without a sink discards its output
+    ~PipelineBuilder()
+    {
+        if (stages)
+        {
+            std::move(*this).sink([](Out&&) {});
+        }
+    }
+
+    // f(Out) -> Next runs on a new stage thread
+    template <typename F>
+    auto then(F f) &&
+    {
+        using Next = std::decay_t<std::invoke_result_t<F&, Out&&>>;
+        auto next = stages->template addQueue<Next>();
+        auto& s = *stages;
+        stages->threads.emplace_back(std::thread { [&s, from = output, next, f = std::move(f)]() mutable {
+            std::vector<Next> results;
+            results.reserve(s.batchSize);
+            s.runStage(*from, [&](std::vector<Out>& batch) {
+                results.clear();
+                for (auto& item : batch)
+                {
+                    results.push_back(f(std::move(item)));
+                }
+                next->push_n(std::make_move_iterator(results.begin()), results.size());
+            });
+            next->close();
+        } }, DtorAction::Join);
+        return PipelineBuilder<In, Next> { input, next, std::move(stages) };
+    }
+
+    // f(Out) consumes the results on the last stage thread
+    template <typename F>
+    Pipeline<In> sink(F f) &&
+    {
+        auto& s = *stages;
+        stages->threads.emplace_back(std::thread { [&s, from = output, f = std::move(f)]() mutable {
+            s.runStage(*from, [&](std::vector<Out>& batch) {
+                for (auto& item : batch)
+                {
+                    f(std::move(item));
+                }
+            });
+        } }, DtorAction::Join);
+        return Pipeline<In> { input, std::move(stages) };
+    }
+};
+
+// capacity is per ring between two stages, batchSize the most items a stage takes at once
+template <typename In>
+PipelineBuilder<In, In> makePipeline(std::size_t capacity = 1024, std::size_t batchSize = 64)
+{
+    auto stages = std::make_unique<detail::PipelineStages>();
+    stages->capacity = capacity;
+    stages->batchSize = batchSize;
+    auto input = stages->template addQueue<In>();
+    return PipelineBuilder<In, In> { input, input, std::move(stages) };
+}
+
+// parse -> transform -> aggregate over numbers given as text
+long sumOfDoubledNumbers(const std::vector<std::string>& lines)
+{
+    long sum = 0;
+    {
+        auto pipeline = makePipeline<std::string>()
+            .then([](std::string line) { return std::stol(line); })
+            .then([](long value) { return value * 2; })
+            .sink([&sum](long value) { sum += value; });
+        pipeline.push_n(lines.begin(), lines.size());
+        pipeline.finish();
+    }
+    return sum;
+}
+
+/*
+ * Item 38: Be aware of varying thread handle destructor behavior
+ */
+
+// the promise/packaged_task wiring of (a + b) feeding two additions that are joined again,
+// as a graph: no thread handles to join and no future to block on in between
+int addDiamond(ThreadPool& pool, int a, int b)
+{
+    int sum = 0;
+    int left = 0;
+    int right = 0;
+    int result = 0;
+
+    TaskGraph graph;
+    auto first = graph.add([&]() { sum = add(a, b); });
+    auto l = graph.add([&]() { left = add(sum, a); });
+    auto r = graph.add([&]() { right = add(sum, b); });
+    auto join = graph.add([&]() { result = add(left, right); });
+    graph.precede(first, l);
+    graph.precede(first, r);
+    graph.precede(l, join);
+    graph.precede(r, join);
+
+    graph.run(pool);
+    return result;
+}
+
 /*
  * Item 40: Use std::atomic for concurrency, volatile for special memory
  */
@@ -132,11 +669,12 @@ public:
 int incrementVolatile(std::size_t numTasks)
 {
     volatile int v = 0;
-    
-    std::promise<void> p;
-    std::future<void> f = p.get_future();
 
-    auto increment = [&v]() {
+    // every worker parks at the gate, so they all start incrementing at the same moment
+    StartGate gate { numTasks };
+
+    auto increment = [&v, &gate]() {
+        gate.arriveAndWait();
         v = v + 1;
         std::this_thread::sleep_for(std::chrono::microseconds(1));
     };
@@ -147,7 +685,8 @@ int incrementVolatile(std::size_t numTasks)
         threads.emplace_back(increment);
     }
 
-    p.set_value();
+    gate.waitUntilReady();
+    gate.open();
 
     for (auto& t : threads) 
     {
@@ -160,11 +699,12 @@ int incrementVolatile(std::size_t numTasks)
 int incrementAtomic(std::size_t numTasks)
 {
     std::atomic<int> v = 0;
-    
-    std::promise<void> p;
-    std::future<void> f = p.get_future();
 
-    auto increment = [&v]() {
+    // every worker parks at the gate, so they all start incrementing at the same moment
+    StartGate gate { numTasks };
+
+    auto increment = [&v, &gate]() {
+        gate.arriveAndWait();
         ++v;
         std::this_thread::sleep_for(std::chrono::microseconds(1));
     };
@@ -175,7 +715,8 @@ int incrementAtomic(std::size_t numTasks)
         threads.emplace_back(increment);
     }
 
-    p.set_value();
+    gate.waitUntilReady();
+    gate.open();
 
     for (auto& t : threads) 
     {
@@ -183,4 +724,70 @@ int incrementAtomic(std::size_t numTasks)
     }
 
     return v;
-}
\ No newline at end of file
+}
+
+int incrementStriped(std::size_t numTasks)
+{
+    StripedCounter v;
+
+    // every worker parks at the gate, so they all start incrementing at the same moment
+    StartGate gate { numTasks };
+
+    auto increment = [&v, &gate]() {
+        gate.arriveAndWait();
+        v.increment();
+        std::this_thread::sleep_for(std::chrono::microseconds(1));
+    };
+
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < numTasks; ++i) 
+    {
+        threads.emplace_back(increment);
+    }
+
+    gate.waitUntilReady();
+    gate.open();
+
+    for (auto& t : threads) 
+    {
+        t.join();
+    }
+
+    return v.getCount();
+}
+
+// single shared atomic with the same interface as the other counters
+class AtomicCounter
+{
+    std::atomic<int> count { 0 };
+public:
+    void increment() noexcept { count.fetch_add(1, std::memory_order_relaxed); }
+    int getCount() const noexcept { return count.load(); }
+};
+
+struct ScalingPoint
+{
+    std::size_t threads;
+    double incrementsPerSecond;
+    long long count; // what the counter read afterwards
+};
+
+// the 1..maxThreads sweep: each thread count hammers a fresh Counter
+template <typename Counter>
+std::vector<ScalingPoint> incrementScaling(std::size_t maxThreads, std::size_t incrementsPerThread)
+{
+    std::vector<ScalingPoint> points;
+    points.reserve(maxThreads);
+    for (std::size_t threads = 1; threads <= maxThreads; ++threads)
+    {
+        Counter counter;
+        auto rate = measureThroughput(threads, incrementsPerThread, [&counter](std::size_t, std::size_t ops) {
+            for (std::size_t i = 0; i < ops; ++i)
+            {
+                counter.increment();
+            }
+        });
+        points.push_back(ScalingPoint { threads, rate, counter.getCount() });
+    }
+    return points;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "SpinWait.h"
+
+/*
+ * Adaptive mutex: spin with exponential backoff, then park on the lock word
+ */
+
+struct MutexStats
+{
+    std::uint64_t acquisitions;
+    std::uint64_t contended;      // acquisitions that missed the uncontended fast path
+    std::uint64_t spinIterations; // pause instructions spent waiting
+    std::uint64_t parks;
+    std::chrono::nanoseconds parkTime;
+};
+
+namespace detail
+{
+    template <bool Enabled>
+    struct MutexCounters
+    {
+        std::atomic<std::uint64_t> acquisitions { 0 };
+        std::atomic<std::uint64_t> contended { 0 };
+        std::atomic<std::uint64_t> spinIterations { 0 };
+        std::atomic<std::uint64_t> parks { 0 };
+        std::atomic<std::int64_t> parkNanos { 0 };
+
+        void acquired() noexcept { acquisitions.fetch_add(1, std::memory_order_relaxed); }
+        void contention() noexcept { contended.fetch_add(1, std::memory_order_relaxed); }
+        void spun(std::uint64_t n) noexcept { spinIterations.fetch_add(n, std::memory_order_relaxed); }
+        void parked(std::chrono::nanoseconds t) noexcept
+        {
+            parks.fetch_add(1, std::memory_order_relaxed);
+            parkNanos.fetch_add(t.count(), std::memory_order_relaxed);
+        }
+        static auto now() noexcept { return std::chrono::steady_clock::now(); }
+    };
+
+    template <>
+    struct MutexCounters<false>
+    {
+        void acquired() noexcept {}
+        void contention() noexcept {}
+        void spun(std::uint64_t) noexcept {}
+        void parked(std::chrono::nanoseconds) noexcept {}
+        static std::chrono::steady_clock::time_point now() noexcept { return {}; }
+    };
+}
+
+// Lock word: 0 free, 1 held, 2 held and somebody may be parked. A contended lock()
+// first spins with doubling pause bursts, which covers critical sections of a few
+// nanoseconds; only then it parks with atomic wait (a futex on Linux). unlock() goes to
+// the kernel only if the word says someone is parked.
+// With CollectStats the mutex counts acquisitions, contention, spins and parked time.
+template <bool CollectStats = false>
+class BasicAdaptiveMutex
+{
+    static constexpr std::uint32_t maxBackoff = 64;
+    static constexpr int spinRounds = 8;
+
+    std::atomic<std::uint32_t> word { 0 };
+    [[no_unique_address]] detail::MutexCounters<CollectStats> counters;
+
+public:
+    BasicAdaptiveMutex() = default;
+    BasicAdaptiveMutex(const BasicAdaptiveMutex&) = delete;
+    BasicAdaptiveMutex& operator=(const BasicAdaptiveMutex&) = delete;
+
+    void lock() noexcept
+    {
+        std::uint32_t expected = 0;
+        if (!word.compare_exchange_strong(expected, 1, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            lockContended();
+        }
+        counters.acquired();
+    }
+
+    bool try_lock() noexcept
+    {
+        std::uint32_t expected = 0;
+        if (word.compare_exchange_strong(expected, 1, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            counters.acquired();
+            return true;
+        }
+        return false;
+    }
+
+    void unlock() noexcept
+    {
+        if (word.exchange(0, std::memory_order_release) == 2)
+        {
+            word.notify_one();
+        }
+    }
+
+    MutexStats stats() const noexcept requires CollectStats
+    {
+        return MutexStats {
+            counters.acquisitions.load(std::memory_order_relaxed),
+            counters.contended.load(std::memory_order_relaxed),
+            counters.spinIterations.load(std::memory_order_relaxed),
+            counters.parks.load(std::memory_order_relaxed),
+            std::chrono::nanoseconds { counters.parkNanos.load(std::memory_order_relaxed) },
+        };
+    }
+
+private:
+    void lockContended() noexcept
+    {
+        counters.contention();
+
+        std::uint32_t backoff = 1;
+        std::uint64_t spins = 0;
+        for (int round = 0; round < spinRounds; ++round)
+        {
+            for (std::uint32_t i = 0; i < backoff; ++i)
+            {
+                cpuRelax();
+            }
+            spins += backoff;
+            backoff = backoff < maxBackoff ? backoff * 2 : backoff;
+
+            std::uint32_t expected = 0;
+            if (word.load(std::memory_order_relaxed) == 0
+                && word.compare_exchange_weak(expected, 1, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                counters.spun(spins);
+                return;
+            }
+        }
+        counters.spun(spins);
+
+        // from here on the word stays at 2 while we hold it, a later unlock may have to wake someone
+        auto parkStart = counters.now();
+        bool slept = false;
+        while (word.exchange(2, std::memory_order_acquire) != 0)
+        {
+            word.wait(2, std::memory_order_relaxed);
+            slept = true;
+        }
+        if (slept)
+        {
+            counters.parked(std::chrono::duration_cast<std::chrono::nanoseconds>(counters.now() - parkStart));
+        }
+    }
+};
+
+using AdaptiveMutex = BasicAdaptiveMutex<false>;
+using InstrumentedAdaptiveMutex = BasicAdaptiveMutex<true>;
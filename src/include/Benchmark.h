@@ -0,0 +1,41 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include "StartGate.h"
+
+/*
+ * Minimal multi-threaded throughput measurement
+ */
+
+// runs fn(threadIndex, opsPerThread) on numThreads threads that start together,
+// returns the total number of operations per second
+template <typename F>
+double measureThroughput(std::size_t numThreads, std::size_t opsPerThread, F&& fn)
+{
+    StartGate gate { numThreads };
+
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads);
+    for (std::size_t i = 0; i < numThreads; ++i)
+    {
+        threads.emplace_back([&, i]() {
+            gate.arriveAndWait();
+            fn(i, opsPerThread);
+        });
+    }
+
+    gate.waitUntilReady();
+    auto begin = std::chrono::steady_clock::now();
+    gate.open();
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+
+    return static_cast<double>(numThreads * opsPerThread) / elapsed.count();
+}
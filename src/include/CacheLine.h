@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+// padding unit that keeps independently written data off each other's cache lines
+#ifdef __cpp_lib_hardware_interference_size
+// GCC warns that the value may differ between -mtune targets, it is only used for padding here
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winterference-size"
+#endif
+inline constexpr std::size_t cacheLineSize = std::hardware_destructive_interference_size;
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#else
+inline constexpr std::size_t cacheLineSize = 64;
+#endif
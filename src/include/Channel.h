@@ -0,0 +1,641 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "StartGate.h"
+
+/*
+ * Go-style channels: bounded buffer, close, batch receive and select over receives
+ */
+
+template <typename T>
+class Channel;
+
+class Select;
+
+namespace detail
+{
+    // how a blocked operation gets going again: a coroutine is resumed by whoever completes it,
+    // a thread parks on the word (a futex on Linux)
+    struct ChannelParker
+    {
+        std::atomic<std::uint32_t> woken { 0 };
+        // set by the waker once it no longer touches the parker, which lives on the parked thread's stack
+        std::atomic<bool> released { false };
+        std::coroutine_handle<> handle;
+
+        void park() noexcept
+        {
+            spinThenPark(woken, [](std::uint32_t w) { return w != 0; });
+            // the waker may still be inside notify_one
+            while (!released.load(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        void wake() noexcept
+        {
+            if (handle)
+            {
+                handle.resume();
+                return;
+            }
+            woken.store(1, std::memory_order_release);
+            woken.notify_one();
+            released.store(true, std::memory_order_release);
+        }
+    };
+
+    // one per blocking operation or select; the first channel to claim it completes it,
+    // the other registrations of a select are dropped when their channel comes across them
+    struct ChannelToken
+    {
+        std::atomic<bool> claimed { false };
+        std::size_t winner = 0;
+
+        bool claim(std::size_t index) noexcept
+        {
+            if (claimed.exchange(true, std::memory_order_acq_rel))
+            {
+                return false;
+            }
+            winner = index;
+            return true;
+        }
+    };
+
+    template <typename T>
+    struct ChannelWaiter
+    {
+        ChannelParker* parker;
+        ChannelToken* token;
+        std::size_t index;
+        std::optional<T>* slot; // receivers get the value here, senders hand theirs over from here
+        bool ok = false;        // false if the channel was closed instead
+        bool linked = false;
+        ChannelWaiter* prev = nullptr;
+        ChannelWaiter* next = nullptr;
+    };
+
+    // intrusive FIFO of the waiters blocked on one side of a channel, guarded by its mutex
+    template <typename T>
+    class ChannelWaiterList
+    {
+        using Waiter = ChannelWaiter<T>;
+
+        Waiter* head = nullptr;
+        Waiter* tail = nullptr;
+
+    public:
+        bool empty() const noexcept { return head == nullptr; }
+
+        void pushBack(Waiter* w) noexcept
+        {
+            w->prev = tail;
+            w->next = nullptr;
+            (tail ? tail->next : head) = w;
+            tail = w;
+            w->linked = true;
+        }
+
+        void remove(Waiter* w) noexcept
+        {
+            if (!w->linked)
+            {
+                return;
+            }
+            (w->prev ? w->prev->next : head) = w->next;
+            (w->next ? w->next->prev : tail) = w->prev;
+            w->prev = w->next = nullptr;
+            w->linked = false;
+        }
+
+        Waiter* popFront() noexcept
+        {
+            auto w = head;
+            if (w)
+            {
+                remove(w);
+            }
+            return w;
+        }
+    };
+}
+
+// A bounded channel; capacity 0 makes every send wait for its receiver (rendezvous).
+// Blocked senders and receivers queue up in FIFO order on the channel and a completing
+// operation hands the value straight to the one in front, so a value is moved from the
+// sender to the buffer to the receiver and never copied: move-only payloads work.
+// Waiters are woken after the mutex is released; a coroutine waiter (asyncSend/asyncRecv)
+// is resumed on the thread that completed its operation.
+// After close() sends fail, receivers drain the buffer and then get nullopt.
+template <typename T>
+class Channel
+{
+    using Waiter = detail::ChannelWaiter<T>;
+
+    enum class Outcome { Done, Blocked, Closed };
+
+    std::mutex mutex;
+    std::vector<std::optional<T>> buffer;
+    std::size_t head = 0;
+    std::size_t count = 0;
+    bool closed = false;
+    detail::ChannelWaiterList<T> receivers;
+    detail::ChannelWaiterList<T> senders;
+
+    friend class Select;
+
+public:
+    explicit Channel(std::size_t capacity = 0) : buffer(capacity) {}
+
+    Channel(const Channel&) = delete;
+    Channel& operator=(const Channel&) = delete;
+
+    std::size_t capacity() const noexcept { return buffer.size(); }
+
+    std::size_t size()
+    {
+        std::lock_guard<std::mutex> lock { mutex };
+        return count;
+    }
+
+    bool isClosed()
+    {
+        std::lock_guard<std::mutex> lock { mutex };
+        return closed;
+    }
+
+    // blocks while the buffer is full, false if the channel is (or gets) closed
+    bool send(T value)
+    {
+        std::unique_lock<std::mutex> lock { mutex };
+        Waiter* woken = nullptr;
+        switch (trySendLocked(value, woken))
+        {
+        case Outcome::Done:
+            lock.unlock();
+            wakeAll(woken);
+            return true;
+        case Outcome::Closed:
+            return false;
+        case Outcome::Blocked:
+            break;
+        }
+
+        std::optional<T> holder { std::move(value) };
+        detail::ChannelParker parker;
+        detail::ChannelToken token;
+        Waiter self { &parker, &token, 0, &holder };
+        senders.pushBack(&self);
+        lock.unlock();
+        parker.park();
+        return self.ok;
+    }
+
+    // moves from value only if it was sent
+    bool try_send(T&& value)
+    {
+        std::unique_lock<std::mutex> lock { mutex };
+        Waiter* woken = nullptr;
+        if (trySendLocked(value, woken) != Outcome::Done)
+        {
+            return false;
+        }
+        lock.unlock();
+        wakeAll(woken);
+        return true;
+    }
+
+    // blocks while the channel is empty, nullopt once it is closed and drained
+    std::optional<T> recv()
+    {
+        std::unique_lock<std::mutex> lock { mutex };
+        std::optional<T> result;
+        Waiter* woken = nullptr;
+        if (tryRecvLocked(result, woken) != Outcome::Blocked)
+        {
+            lock.unlock();
+            wakeAll(woken);
+            return result;
+        }
+
+        detail::ChannelParker parker;
+        detail::ChannelToken token;
+        Waiter self { &parker, &token, 0, &result };
+        receivers.pushBack(&self);
+        lock.unlock();
+        parker.park();
+        return result;
+    }
+
+    // nullopt if nothing is ready right now
+    std::optional<T> try_recv()
+    {
+        std::unique_lock<std::mutex> lock { mutex };
+        std::optional<T> result;
+        Waiter* woken = nullptr;
+        tryRecvLocked(result, woken);
+        lock.unlock();
+        wakeAll(woken);
+        return result;
+    }
+
+    // blocks until at least one value is there and moves up to maxCount to out under one lock,
+    // 0 means closed and drained
+    template <typename OutIt>
+    std::size_t recv_n(OutIt out, std::size_t maxCount)
+    {
+        if (maxCount == 0)
+        {
+            return 0;
+        }
+        auto first = recv();
+        if (!first)
+        {
+            return 0;
+        }
+        *out = std::move(*first);
+        ++out;
+
+        std::size_t n = 1;
+        Waiter* woken = nullptr;
+        {
+            std::lock_guard<std::mutex> lock { mutex };
+            for (std::optional<T> value; n < maxCount && tryRecvLocked(value, woken) == Outcome::Done; ++n, ++out)
+            {
+                *out = std::move(*value);
+                value.reset();
+            }
+        }
+        wakeAll(woken);
+        return n;
+    }
+
+    // wakes everyone blocked: senders fail, receivers get nullopt once the buffer is drained
+    void close()
+    {
+        Waiter* woken = nullptr;
+        {
+            std::lock_guard<std::mutex> lock { mutex };
+            if (closed)
+            {
+                return;
+            }
+            closed = true;
+            for (auto list : { &receivers, &senders })
+            {
+                while (auto w = claimFront(*list))
+                {
+                    w->ok = false;
+                    w->next = woken;
+                    woken = w;
+                }
+            }
+        }
+        wakeAll(woken);
+    }
+
+    /*
+     * Coroutine side: co_await channel.asyncSend(value) / co_await channel.asyncRecv()
+     */
+
+    class SendAwaiter
+    {
+        Channel& channel;
+        std::optional<T> holder;
+        detail::ChannelParker parker;
+        detail::ChannelToken token;
+        Waiter self { &parker, &token, 0, &holder };
+        bool sent = false;
+
+    public:
+        SendAwaiter(Channel& c, T value) : channel { c }, holder { std::move(value) } {}
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            std::unique_lock<std::mutex> lock { channel.mutex };
+            Waiter* woken = nullptr;
+            switch (channel.trySendLocked(*holder, woken))
+            {
+            case Outcome::Done:
+                lock.unlock();
+                channel.wakeAll(woken);
+                sent = true;
+                return false;
+            case Outcome::Closed:
+                return false;
+            case Outcome::Blocked:
+                break;
+            }
+            parker.handle = handle;
+            channel.senders.pushBack(&self);
+            return true;
+        }
+
+        // false if the channel was closed
+        bool await_resume() const noexcept { return sent || self.ok; }
+    };
+
+    class RecvAwaiter
+    {
+        Channel& channel;
+        std::optional<T> result;
+        detail::ChannelParker parker;
+        detail::ChannelToken token;
+        Waiter self { &parker, &token, 0, &result };
+
+    public:
+        explicit RecvAwaiter(Channel& c) : channel { c } {}
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            std::unique_lock<std::mutex> lock { channel.mutex };
+            Waiter* woken = nullptr;
+            if (channel.tryRecvLocked(result, woken) != Outcome::Blocked)
+            {
+                lock.unlock();
+                channel.wakeAll(woken);
+                return false;
+            }
+            parker.handle = handle;
+            channel.receivers.pushBack(&self);
+            return true;
+        }
+
+        std::optional<T> await_resume() { return std::move(result); }
+    };
+
+    SendAwaiter asyncSend(T value) { return SendAwaiter { *this, std::move(value) }; }
+    RecvAwaiter asyncRecv() { return RecvAwaiter { *this }; }
+
+private:
+    // pops waiters until one can be claimed; the ones some other channel of their select
+    // already claimed are dropped on the way
+    static Waiter* claimFront(detail::ChannelWaiterList<T>& list) noexcept
+    {
+        while (auto w = list.popFront())
+        {
+            if (w->token->claim(w->index))
+            {
+                w->next = nullptr;
+                return w;
+            }
+        }
+        return nullptr;
+    }
+
+    // all of the trySend/tryRecv helpers run under the mutex and chain the waiters they
+    // completed onto woken, to be woken by wakeAll once the mutex is released
+    static void wakeAll(Waiter* woken) noexcept
+    {
+        while (woken)
+        {
+            // the waiter may be gone as soon as it is woken
+            auto next = woken->next;
+            woken->parker->wake();
+            woken = next;
+        }
+    }
+
+    void pushBuffer(T&& value)
+    {
+        buffer[(head + count) % buffer.size()].emplace(std::move(value));
+        ++count;
+    }
+
+    T popBuffer()
+    {
+        auto& slot = buffer[head];
+        T value { std::move(*slot) };
+        slot.reset();
+        head = (head + 1) % buffer.size();
+        --count;
+        return value;
+    }
+
+    Outcome trySendLocked(T& value, Waiter*& woken)
+    {
+        if (closed)
+        {
+            return Outcome::Closed;
+        }
+        if (auto receiver = claimFront(receivers))
+        {
+            receiver->slot->emplace(std::move(value));
+            receiver->ok = true;
+            receiver->next = woken;
+            woken = receiver;
+            return Outcome::Done;
+        }
+        if (count < buffer.size())
+        {
+            pushBuffer(std::move(value));
+            return Outcome::Done;
+        }
+        return Outcome::Blocked;
+    }
+
+    // Closed leaves out empty
+    Outcome tryRecvLocked(std::optional<T>& out, Waiter*& woken)
+    {
+        if (count > 0)
+        {
+            out.emplace(popBuffer());
+            // the freed slot goes to the sender waiting longest
+            if (auto sender = claimFront(senders))
+            {
+                pushBuffer(std::move(**sender->slot));
+                completeSender(sender, woken);
+            }
+            return Outcome::Done;
+        }
+        if (auto sender = claimFront(senders))
+        {
+            out.emplace(std::move(**sender->slot));
+            completeSender(sender, woken);
+            return Outcome::Done;
+        }
+        return closed ? Outcome::Closed : Outcome::Blocked;
+    }
+
+    static void completeSender(Waiter* sender, Waiter*& woken) noexcept
+    {
+        sender->slot->reset();
+        sender->ok = true;
+        sender->next = woken;
+        woken = sender;
+    }
+
+    // a sender never takes part in a select, so a waiting one can always be claimed
+    bool canRecvLocked() const noexcept
+    {
+        return count > 0 || !senders.empty() || closed;
+    }
+};
+
+// Waits on several channels at once and runs the handler of the receive that completes first:
+//
+//     Select {}.recv(requests, [](std::optional<Request> r) { ... })
+//              .recv(quit, [](std::optional<int>) { ... })
+//              .wait();
+//
+// A handler gets nullopt if its channel is closed and drained. Ready cases are polled
+// starting from a rotating position so that a busy channel can not starve the others;
+// if none is ready the select registers one waiter per channel, all sharing one token,
+// and parks until some channel claims it.
+class Select
+{
+    struct Case
+    {
+        virtual ~Case() = default;
+
+        // completes the case if it does not have to wait
+        virtual bool tryNow() = 0;
+        // true if the case completed right away and the token was claimed for it
+        virtual bool enqueue(detail::ChannelParker& parker, detail::ChannelToken& token, std::size_t index) = 0;
+        virtual void dequeue() noexcept = 0;
+        virtual void fire() = 0;
+    };
+
+    template <typename T, typename F>
+    struct RecvCase final : Case
+    {
+        Channel<T>& channel;
+        F handler;
+        std::optional<T> result;
+        detail::ChannelWaiter<T> waiter { nullptr, nullptr, 0, &result };
+
+        RecvCase(Channel<T>& c, F f) : channel { c }, handler { std::move(f) } {}
+
+        bool tryNow() override
+        {
+            std::unique_lock<std::mutex> lock { channel.mutex };
+            detail::ChannelWaiter<T>* woken = nullptr;
+            if (channel.tryRecvLocked(result, woken) == Channel<T>::Outcome::Blocked)
+            {
+                return false;
+            }
+            lock.unlock();
+            Channel<T>::wakeAll(woken);
+            return true;
+        }
+
+        bool enqueue(detail::ChannelParker& parker, detail::ChannelToken& token, std::size_t index) override
+        {
+            std::unique_lock<std::mutex> lock { channel.mutex };
+            if (!channel.canRecvLocked())
+            {
+                waiter.parker = &parker;
+                waiter.token = &token;
+                waiter.index = index;
+                channel.receivers.pushBack(&waiter);
+                return false;
+            }
+            if (!token.claim(index))
+            {
+                // another channel got here first, its wake-up is on the way
+                return false;
+            }
+            detail::ChannelWaiter<T>* woken = nullptr;
+            channel.tryRecvLocked(result, woken);
+            lock.unlock();
+            Channel<T>::wakeAll(woken);
+            return true;
+        }
+
+        void dequeue() noexcept override
+        {
+            std::lock_guard<std::mutex> lock { channel.mutex };
+            channel.receivers.remove(&waiter);
+        }
+
+        void fire() override
+        {
+            auto value = std::exchange(result, std::nullopt);
+            handler(std::move(value));
+        }
+    };
+
+    std::vector<std::unique_ptr<Case>> cases;
+    std::size_t start = 0;
+
+public:
+    // f(std::optional<T>) runs if this receive wins
+    template <typename T, typename F>
+    Select& recv(Channel<T>& channel, F&& f)
+    {
+        cases.push_back(std::make_unique<RecvCase<T, std::decay_t<F>>>(channel, std::forward<F>(f)));
+        return *this;
+    }
+
+    // blocks until one case completes, runs its handler and returns its index
+    std::size_t wait()
+    {
+        if (auto index = poll())
+        {
+            return *index;
+        }
+
+        detail::ChannelParker parker;
+        detail::ChannelToken token;
+        bool completedHere = false;
+        std::size_t registered = 0;
+        for (; registered < cases.size() && !token.claimed.load(std::memory_order_acquire); ++registered)
+        {
+            if (cases[registered]->enqueue(parker, token, registered))
+            {
+                completedHere = true;
+                ++registered;
+                break;
+            }
+        }
+        if (!completedHere)
+        {
+            parker.park();
+        }
+        for (std::size_t i = 0; i < registered; ++i)
+        {
+            cases[i]->dequeue();
+        }
+
+        cases[token.winner]->fire();
+        return token.winner;
+    }
+
+    // a select with a default case: runs a ready case if there is one, never blocks
+    std::optional<std::size_t> poll()
+    {
+        if (cases.empty())
+        {
+            throw std::logic_error("select without cases");
+        }
+        auto first = start++ % cases.size();
+        for (std::size_t k = 0; k < cases.size(); ++k)
+        {
+            auto i = (first + k) % cases.size();
+            if (cases[i]->tryNow())
+            {
+                cases[i]->fire();
+                return i;
+            }
+        }
+        return std::nullopt;
+    }
+};
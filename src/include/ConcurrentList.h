@@ -0,0 +1,213 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <utility>
+
+#include "EpochReclamation.h"
+
+/*
+ * Lock-free ordered list (Harris-Michael) with epoch-based reclamation
+ */
+
+// A sorted set of unique values. The lowest bit of a node's next word marks the node as
+// deleted: erase first marks, then unlinks, and any traversal that runs into a marked node
+// helps unlinking it. Unlinked nodes are retired to an EpochDomain and freed once no pinned
+// reader can reach them, so a reader never touches freed memory.
+// insert and erase are lock-free; contains walks the list without writing anything or
+// retrying, it only looks at the mark of the node it ends on.
+template <typename T, typename Compare = std::less<T>>
+class ConcurrentList
+{
+    struct Node
+    {
+        T value;
+        std::atomic<std::uintptr_t> next;
+
+        Node(T v, std::uintptr_t n) : value { std::move(v) }, next { n } {}
+    };
+
+    static constexpr std::uintptr_t deletedMark = 1;
+
+    static Node* pointer(std::uintptr_t word) noexcept { return reinterpret_cast<Node*>(word & ~deletedMark); }
+    static bool isMarked(std::uintptr_t word) noexcept { return (word & deletedMark) != 0; }
+    static std::uintptr_t word(Node* node) noexcept { return reinterpret_cast<std::uintptr_t>(node); }
+
+    std::atomic<std::uintptr_t> head { 0 };
+    EpochDomain& domain;
+    [[no_unique_address]] Compare less;
+
+    struct Position
+    {
+        std::atomic<std::uintptr_t>* prev; // the link that points to curr
+        Node* curr;                        // first node not less than the value, or nullptr
+    };
+
+public:
+    explicit ConcurrentList(EpochDomain& domain = defaultEpochDomain(), Compare compare = Compare {})
+        : domain { domain }, less { std::move(compare) }
+    {
+    }
+
+    ConcurrentList(const ConcurrentList&) = delete;
+    ConcurrentList& operator=(const ConcurrentList&) = delete;
+
+    // no other thread may use the list any more
+    ~ConcurrentList()
+    {
+        auto node = pointer(head.load(std::memory_order_relaxed));
+        while (node != nullptr)
+        {
+            delete std::exchange(node, pointer(node->next.load(std::memory_order_relaxed)));
+        }
+    }
+
+    // false if the value is already there
+    bool insert(T value)
+    {
+        auto guard = domain.pin();
+        Node* node = nullptr;
+        while (true)
+        {
+            // once the node exists the value lives in it
+            const T& key = node ? node->value : value;
+            auto [prev, curr] = find(key);
+            if (curr != nullptr && !less(key, curr->value))
+            {
+                delete node;
+                return false;
+            }
+            if (node == nullptr)
+            {
+                node = new Node { std::move(value), word(curr) };
+            }
+            else
+            {
+                node->next.store(word(curr), std::memory_order_relaxed);
+            }
+            auto expected = word(curr);
+            if (prev->compare_exchange_strong(expected, word(node), std::memory_order_release, std::memory_order_relaxed))
+            {
+                return true;
+            }
+        }
+    }
+
+    // false if the value was not there
+    bool erase(const T& value)
+    {
+        auto guard = domain.pin();
+        while (true)
+        {
+            auto [prev, curr] = find(value);
+            if (curr == nullptr || less(value, curr->value))
+            {
+                return false;
+            }
+
+            // the mark decides which erase wins, unlinking is cleanup anyone may do
+            auto next = curr->next.load(std::memory_order_acquire);
+            if (isMarked(next))
+            {
+                continue;
+            }
+            if (!curr->next.compare_exchange_strong(next, next | deletedMark, std::memory_order_acq_rel,
+                                                    std::memory_order_relaxed))
+            {
+                continue;
+            }
+
+            auto expected = word(curr);
+            if (prev->compare_exchange_strong(expected, next, std::memory_order_acq_rel, std::memory_order_relaxed))
+            {
+                domain.retire(curr);
+            }
+            else
+            {
+                find(value);
+            }
+            return true;
+        }
+    }
+
+    bool contains(const T& value) const
+    {
+        auto guard = domain.pin();
+        auto curr = pointer(head.load(std::memory_order_acquire));
+        while (curr != nullptr && less(curr->value, value))
+        {
+            curr = pointer(curr->next.load(std::memory_order_acquire));
+        }
+        return curr != nullptr && !less(value, curr->value) && !isMarked(curr->next.load(std::memory_order_acquire));
+    }
+
+    // calls f with every value not marked deleted, in order; concurrent updates may or may not be seen
+    template <typename F>
+    void forEach(F&& f) const
+    {
+        auto guard = domain.pin();
+        for (auto curr = pointer(head.load(std::memory_order_acquire)); curr != nullptr;)
+        {
+            auto next = curr->next.load(std::memory_order_acquire);
+            if (!isMarked(next))
+            {
+                f(curr->value);
+            }
+            curr = pointer(next);
+        }
+    }
+
+    // exact only while no update runs
+    std::size_t size() const
+    {
+        std::size_t count = 0;
+        forEach([&count](const T&) { ++count; });
+        return count;
+    }
+
+private:
+    // callers are pinned; unlinks the marked nodes it passes and starts over whenever a link
+    // it relies on changed under it
+    Position find(const T& value)
+    {
+        while (true)
+        {
+            if (auto position = tryFind(value))
+            {
+                return *position;
+            }
+        }
+    }
+
+    std::optional<Position> tryFind(const T& value)
+    {
+        auto prev = &head;
+        auto curr = pointer(prev->load(std::memory_order_acquire));
+        while (curr != nullptr)
+        {
+            auto next = curr->next.load(std::memory_order_acquire);
+            if (isMarked(next))
+            {
+                auto expected = word(curr);
+                if (!prev->compare_exchange_strong(expected, next & ~deletedMark, std::memory_order_acq_rel,
+                                                   std::memory_order_relaxed))
+                {
+                    return std::nullopt;
+                }
+                domain.retire(curr);
+                curr = pointer(next);
+                continue;
+            }
+            if (!less(curr->value, value))
+            {
+                break;
+            }
+            prev = &curr->next;
+            curr = pointer(next);
+        }
+        return Position { prev, curr };
+    }
+};
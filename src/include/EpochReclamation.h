@@ -0,0 +1,420 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "CacheLine.h"
+
+/*
+ * Safe memory reclamation: epochs for short critical sections, hazard pointers for long-lived readers
+ */
+
+namespace detail
+{
+    // a node that was unlinked but may still be read by someone, freed through a type-erased deleter
+    struct Retired
+    {
+        void* ptr;
+        void (*deleter)(void*);
+        std::uint64_t epoch;
+
+        void destroy() const { deleter(ptr); }
+    };
+
+    // stateless deleters only, so retiring never allocates beyond the retired list itself
+    template <typename T, typename D>
+    void (*erasedDeleter())(void*)
+    {
+        static_assert(std::is_empty_v<D> && std::is_default_constructible_v<D>,
+                      "retire takes stateless deleters");
+        return [](void* p) { D {}(static_cast<T*>(p)); };
+    }
+
+    inline std::uint64_t nextDomainId() noexcept
+    {
+        static std::atomic<std::uint64_t> counter { 0 };
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    // One Record per thread and domain. Records outlive the threads that used them and are
+    // adopted by new threads; the thread-local cache keys them by a domain id that is never
+    // reused, so a destroyed domain can not be confused with a new one at the same address.
+    template <typename Record>
+    class ThreadRecords
+    {
+        struct CacheEntry
+        {
+            std::uint64_t domainId;
+            std::shared_ptr<Record> record;
+        };
+
+        struct ThreadCache
+        {
+            std::vector<CacheEntry> entries;
+
+            ~ThreadCache()
+            {
+                for (auto& entry : entries)
+                {
+                    entry.record->inUse.store(false, std::memory_order_release);
+                }
+            }
+        };
+
+        static ThreadCache& cache()
+        {
+            thread_local ThreadCache threadCache;
+            return threadCache;
+        }
+
+        std::uint64_t id { nextDomainId() };
+        mutable std::mutex mutex;
+        std::vector<std::shared_ptr<Record>> records;
+
+    public:
+        Record& local()
+        {
+            auto& entries = cache().entries;
+            for (auto& entry : entries)
+            {
+                if (entry.domainId == id)
+                {
+                    return *entry.record;
+                }
+            }
+
+            std::shared_ptr<Record> record;
+            {
+                std::lock_guard<std::mutex> lock { mutex };
+                for (auto& candidate : records)
+                {
+                    if (!candidate->inUse.exchange(true, std::memory_order_acquire))
+                    {
+                        record = candidate;
+                        break;
+                    }
+                }
+                if (!record)
+                {
+                    record = std::make_shared<Record>();
+                    record->inUse.store(true, std::memory_order_relaxed);
+                    records.push_back(record);
+                }
+            }
+            // drop entries of domains that no longer exist before the cache grows
+            std::erase_if(entries, [](const CacheEntry& entry) { return entry.record.use_count() == 1; });
+            entries.push_back(CacheEntry { id, record });
+            return *record;
+        }
+
+        template <typename F>
+        void forEach(F&& f) const
+        {
+            std::lock_guard<std::mutex> lock { mutex };
+            for (auto& record : records)
+            {
+                f(*record);
+            }
+        }
+    };
+}
+
+/*
+ * Epoch-based reclamation
+ */
+
+// Readers pin the current epoch for the length of a critical section and touch no shared
+// counters on the way; a retired node is freed once the global epoch has moved twice past
+// the epoch it was retired in, at which point no pinned reader can still see it.
+// A reader that stays pinned for long holds back every free in the domain.
+class EpochDomain
+{
+    static constexpr std::size_t collectEvery = 64;
+
+    struct Record
+    {
+        // 0 while outside a critical section, the pinned epoch otherwise
+        alignas(cacheLineSize) std::atomic<std::uint64_t> localEpoch { 0 };
+        std::atomic<bool> inUse { false };
+        std::size_t nesting = 0;
+        std::size_t sinceCollect = 0;
+        std::vector<detail::Retired> retired;
+    };
+
+    alignas(cacheLineSize) std::atomic<std::uint64_t> epoch { 1 };
+    detail::ThreadRecords<Record> records;
+
+public:
+    class Guard
+    {
+        EpochDomain* domain;
+
+    public:
+        explicit Guard(EpochDomain& d) : domain { &d } { domain->enter(); }
+        Guard(Guard&& other) noexcept : domain { std::exchange(other.domain, nullptr) } {}
+        Guard& operator=(Guard&&) = delete;
+        ~Guard()
+        {
+            if (domain)
+            {
+                domain->leave();
+            }
+        }
+    };
+
+    EpochDomain() = default;
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    // no thread may be inside a critical section any more, whatever is still retired is freed now
+    ~EpochDomain()
+    {
+        records.forEach([](Record& record) {
+            for (auto& r : record.retired)
+            {
+                r.destroy();
+            }
+            record.retired.clear();
+        });
+    }
+
+    // critical sections nest, only the outermost one pins
+    void enter()
+    {
+        auto& record = records.local();
+        if (record.nesting++ == 0)
+        {
+            record.localEpoch.store(epoch.load(std::memory_order_seq_cst), std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+        }
+    }
+
+    void leave()
+    {
+        auto& record = records.local();
+        if (--record.nesting == 0)
+        {
+            record.localEpoch.store(0, std::memory_order_release);
+        }
+    }
+
+    [[nodiscard]] Guard pin() { return Guard { *this }; }
+
+    // p must already be unreachable for new readers
+    template <typename T, typename D = std::default_delete<T>>
+    void retire(T* p, D = {})
+    {
+        auto& record = records.local();
+        record.retired.push_back(detail::Retired { p, detail::erasedDeleter<T, D>(),
+                                                   epoch.load(std::memory_order_seq_cst) });
+        if (++record.sinceCollect >= collectEvery)
+        {
+            record.sinceCollect = 0;
+            tryAdvance();
+            collect(record);
+        }
+    }
+
+    // advances the epoch if every pinned thread has caught up and frees this thread's safe nodes,
+    // returns how many nodes this thread still holds
+    std::size_t collect()
+    {
+        tryAdvance();
+        tryAdvance();
+        auto& record = records.local();
+        collect(record);
+        return record.retired.size();
+    }
+
+    std::uint64_t currentEpoch() const noexcept { return epoch.load(std::memory_order_relaxed); }
+
+private:
+    bool tryAdvance()
+    {
+        auto current = epoch.load(std::memory_order_seq_cst);
+        bool laggard = false;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        records.forEach([&](const Record& record) {
+            auto local = record.localEpoch.load(std::memory_order_seq_cst);
+            laggard = laggard || (local != 0 && local != current);
+        });
+        return !laggard && epoch.compare_exchange_strong(current, current + 1, std::memory_order_seq_cst);
+    }
+
+    void collect(Record& record)
+    {
+        auto safe = epoch.load(std::memory_order_seq_cst);
+        // retired in epoch order, so the freeable ones are a prefix
+        auto end = std::find_if(record.retired.begin(), record.retired.end(), [safe](const detail::Retired& r) {
+            return r.epoch + 2 > safe;
+        });
+        // deleters may retire further nodes, so take the batch out of the list first
+        std::vector<detail::Retired> batch { record.retired.begin(), end };
+        record.retired.erase(record.retired.begin(), end);
+        for (auto& r : batch)
+        {
+            r.destroy();
+        }
+    }
+};
+
+inline EpochDomain& defaultEpochDomain()
+{
+    static EpochDomain domain;
+    return domain;
+}
+
+/*
+ * Hazard pointers
+ */
+
+// Each reader publishes the nodes it is about to use in a few per-thread slots; a node is
+// freed only when no slot points to it. Costs a fence per protected pointer instead of per
+// critical section, but a stalled reader pins at most its own slots, not the whole domain.
+template <std::size_t SlotsPerThread = 4>
+class HazardDomain
+{
+    static constexpr std::size_t scanEvery = 64;
+
+    struct Record
+    {
+        alignas(cacheLineSize) std::array<std::atomic<void*>, SlotsPerThread> slots {};
+        std::atomic<bool> inUse { false };
+        std::array<bool, SlotsPerThread> taken {};
+        std::vector<detail::Retired> retired;
+    };
+
+    detail::ThreadRecords<Record> records;
+
+public:
+    // owns one slot of the calling thread, must stay on that thread
+    class Hazard
+    {
+        Record* record;
+        std::size_t slot;
+
+        friend class HazardDomain;
+
+        Hazard(Record& r, std::size_t s) noexcept : record { &r }, slot { s } {}
+
+    public:
+        Hazard(Hazard&& other) noexcept : record { std::exchange(other.record, nullptr) }, slot { other.slot } {}
+        Hazard& operator=(Hazard&&) = delete;
+
+        ~Hazard()
+        {
+            if (record)
+            {
+                reset();
+                record->taken[slot] = false;
+            }
+        }
+
+        // loads src until the published value is still current, the result stays valid until reset
+        template <typename T>
+        T* protect(const std::atomic<T*>& src) noexcept
+        {
+            auto p = src.load(std::memory_order_relaxed);
+            while (true)
+            {
+                record->slots[slot].store(p, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                auto again = src.load(std::memory_order_acquire);
+                if (again == p)
+                {
+                    return p;
+                }
+                p = again;
+            }
+        }
+
+        void reset() noexcept
+        {
+            record->slots[slot].store(nullptr, std::memory_order_release);
+        }
+    };
+
+    HazardDomain() = default;
+    HazardDomain(const HazardDomain&) = delete;
+    HazardDomain& operator=(const HazardDomain&) = delete;
+
+    ~HazardDomain()
+    {
+        records.forEach([](Record& record) {
+            for (auto& r : record.retired)
+            {
+                r.destroy();
+            }
+            record.retired.clear();
+        });
+    }
+
+    Hazard makeHazard()
+    {
+        auto& record = records.local();
+        for (std::size_t i = 0; i < SlotsPerThread; ++i)
+        {
+            if (!record.taken[i])
+            {
+                record.taken[i] = true;
+                return Hazard { record, i };
+            }
+        }
+        throw std::length_error("no free hazard slot on this thread");
+    }
+
+    template <typename T, typename D = std::default_delete<T>>
+    void retire(T* p, D = {})
+    {
+        auto& record = records.local();
+        record.retired.push_back(detail::Retired { p, detail::erasedDeleter<T, D>(), 0 });
+        if (record.retired.size() % scanEvery == 0)
+        {
+            scan(record);
+        }
+    }
+
+    // frees this thread's unprotected nodes, returns how many it still holds
+    std::size_t collect()
+    {
+        auto& record = records.local();
+        scan(record);
+        return record.retired.size();
+    }
+
+private:
+    void scan(Record& record)
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::vector<void*> protectedPtrs;
+        records.forEach([&](const Record& other) {
+            for (auto& s : other.slots)
+            {
+                if (auto p = s.load(std::memory_order_acquire))
+                {
+                    protectedPtrs.push_back(p);
+                }
+            }
+        });
+        std::sort(protectedPtrs.begin(), protectedPtrs.end());
+
+        auto keep = std::stable_partition(record.retired.begin(), record.retired.end(), [&](const detail::Retired& r) {
+            return std::binary_search(protectedPtrs.begin(), protectedPtrs.end(), r.ptr);
+        });
+        std::vector<detail::Retired> batch { keep, record.retired.end() };
+        record.retired.erase(keep, record.retired.end());
+        for (auto& r : batch)
+        {
+            r.destroy();
+        }
+    }
+};
@@ -0,0 +1,485 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ThreadPool.h"
+
+/*
+ * Future with continuations, when_all and when_any
+ */
+
+template <typename T>
+class Future;
+
+template <typename T>
+class Promise;
+
+namespace detail
+{
+    struct Unit {};
+
+    template <typename T>
+    using StoredType = std::conditional_t<std::is_void_v<T>, Unit, T>;
+
+    // at most one continuation, it runs on the thread that completes the state
+    template <typename T>
+    struct FutureState
+    {
+        std::mutex mutex;
+        std::condition_variable readyCondition;
+        bool ready = false;
+        std::optional<StoredType<T>> value;
+        std::exception_ptr error;
+        Job continuation;
+
+        template <typename... Ts>
+        void setValue(Ts&&... params)
+        {
+            complete([&]() { value.emplace(std::forward<Ts>(params)...); });
+        }
+
+        void setException(std::exception_ptr e)
+        {
+            complete([&]() { error = std::move(e); });
+        }
+
+        void setContinuation(Job job)
+        {
+            {
+                std::lock_guard<std::mutex> lock { mutex };
+                if (!ready)
+                {
+                    continuation = std::move(job);
+                    return;
+                }
+            }
+            job();
+        }
+
+        void wait()
+        {
+            std::unique_lock<std::mutex> lock { mutex };
+            readyCondition.wait(lock, [this] { return ready; });
+        }
+
+        bool isReady()
+        {
+            std::lock_guard<std::mutex> lock { mutex };
+            return ready;
+        }
+
+    private:
+        template <typename F>
+        void complete(F&& store)
+        {
+            Job next;
+            {
+                std::lock_guard<std::mutex> lock { mutex };
+                if (ready)
+                {
+                    throw std::future_error(std::future_errc::promise_already_satisfied);
+                }
+                store();
+                ready = true;
+                next = std::move(continuation);
+            }
+            readyCondition.notify_all();
+            if (next)
+            {
+                next();
+            }
+        }
+    };
+
+    // invokes f on the value (if any) and completes the promise with its result or exception
+    template <typename R, typename F, typename... Ts>
+    void fulfil(Promise<R>& promise, F& f, Ts&&... params) noexcept
+    {
+        try
+        {
+            if constexpr (std::is_void_v<R>)
+            {
+                std::invoke(f, std::forward<Ts>(params)...);
+                promise.set_value();
+            }
+            else
+            {
+                promise.set_value(std::invoke(f, std::forward<Ts>(params)...));
+            }
+        }
+        catch (...)
+        {
+            promise.set_exception(std::current_exception());
+        }
+    }
+}
+
+template <typename T>
+class Future
+{
+    std::shared_ptr<detail::FutureState<T>> state;
+
+    template <typename U>
+    friend class Promise;
+    template <typename U>
+    friend class Future;
+
+    explicit Future(std::shared_ptr<detail::FutureState<T>> s) noexcept : state { std::move(s) } {}
+
+public:
+    Future() noexcept = default;
+    Future(Future&&) noexcept = default;
+    Future& operator=(Future&&) noexcept = default;
+    Future(const Future&) = delete;
+    Future& operator=(const Future&) = delete;
+
+    bool valid() const noexcept { return state != nullptr; }
+    bool isReady() const { return state->isReady(); }
+    void wait() const { state->wait(); }
+
+    T get()
+    {
+        auto s = std::move(state);
+        s->wait();
+        if (s->error)
+        {
+            std::rethrow_exception(s->error);
+        }
+        if constexpr (!std::is_void_v<T>)
+        {
+            return std::move(*s->value);
+        }
+    }
+
+    // f receives this future once it is ready, holding either a value or an exception
+    template <typename F>
+    void whenReady(F&& f)
+    {
+        auto s = std::move(state);
+        auto raw = s.get();
+        raw->setContinuation([s = std::move(s), f = std::forward<F>(f)]() mutable {
+            std::invoke(f, Future<T> { std::move(s) });
+        });
+    }
+
+    // f receives the value and runs where the value is produced, or right here if it already is;
+    // an exception skips f and travels down the chain
+    template <typename F>
+    auto then(F&& f)
+    {
+        using R = typename std::conditional_t<std::is_void_v<T>,
+                                              std::invoke_result<std::decay_t<F>&>,
+                                              std::invoke_result<std::decay_t<F>&, T>>::type;
+
+        Promise<R> next;
+        auto result = next.get_future();
+        whenReady([f = std::forward<F>(f), next = std::move(next)](Future<T> ready) mutable {
+            if (ready.state->error)
+            {
+                next.set_exception(ready.state->error);
+            }
+            else if constexpr (std::is_void_v<T>)
+            {
+                detail::fulfil(next, f);
+            }
+            else
+            {
+                detail::fulfil(next, f, std::move(*ready.state->value));
+            }
+        });
+        return result;
+    }
+
+    // same as above, but f is posted to the pool instead of running on the completing thread
+    template <typename F>
+    auto then(ThreadPool& pool, F&& f)
+    {
+        return then([&pool, f = std::forward<F>(f)]<typename... Ts>(Ts&&... value) mutable {
+            using R = std::invoke_result_t<std::decay_t<F>&, Ts...>;
+            Promise<R> promise;
+            auto future = promise.get_future();
+            pool.post([f = std::move(f), promise = std::move(promise), ... value = std::forward<Ts>(value)]() mutable {
+                detail::fulfil(promise, f, std::move(value)...);
+            });
+            return future;
+        }).unwrap();
+    }
+
+    // Future<Future<U>> -> Future<U>
+    auto unwrap()
+    {
+        using Inner = decltype(std::declval<T>().get());
+
+        Promise<Inner> next;
+        auto result = next.get_future();
+        whenReady([next = std::move(next)](Future<T> outer) mutable {
+            if (outer.state->error)
+            {
+                next.set_exception(outer.state->error);
+                return;
+            }
+            std::move(*outer.state->value).whenReady([next = std::move(next)](Future<Inner> inner) mutable {
+                if (inner.state->error)
+                {
+                    next.set_exception(inner.state->error);
+                }
+                else if constexpr (std::is_void_v<Inner>)
+                {
+                    next.set_value();
+                }
+                else
+                {
+                    next.set_value(std::move(*inner.state->value));
+                }
+            });
+        });
+        return result;
+    }
+};
+
+template <typename T>
+class Promise
+{
+    std::shared_ptr<detail::FutureState<T>> state;
+    bool retrieved = false;
+
+public:
+    Promise() : state { std::make_shared<detail::FutureState<T>>() } {}
+    Promise(Promise&&) noexcept = default;
+    Promise& operator=(Promise&& other) noexcept
+    {
+        if (this != &other)
+        {
+            abandon();
+            state = std::move(other.state);
+            retrieved = other.retrieved;
+        }
+        return *this;
+    }
+    Promise(const Promise&) = delete;
+    Promise& operator=(const Promise&) = delete;
+
+    ~Promise() { abandon(); }
+
+    Future<T> get_future()
+    {
+        if (retrieved)
+        {
+            throw std::future_error(std::future_errc::future_already_retrieved);
+        }
+        retrieved = true;
+        return Future<T> { state };
+    }
+
+    template <typename... Ts>
+    void set_value(Ts&&... params)
+    {
+        satisfy()->setValue(std::forward<Ts>(params)...);
+    }
+
+    void set_exception(std::exception_ptr e)
+    {
+        satisfy()->setException(std::move(e));
+    }
+
+private:
+    std::shared_ptr<detail::FutureState<T>> satisfy()
+    {
+        if (!state)
+        {
+            throw std::future_error(std::future_errc::promise_already_satisfied);
+        }
+        return std::exchange(state, nullptr);
+    }
+
+    // a promise dropped without a value breaks its future, just like std::promise
+    void abandon() noexcept
+    {
+        if (state)
+        {
+            std::exchange(state, nullptr)->setException(
+                std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+        }
+    }
+};
+
+template <typename T>
+Future<std::decay_t<T>> makeReadyFuture(T&& value)
+{
+    Promise<std::decay_t<T>> promise;
+    auto future = promise.get_future();
+    promise.set_value(std::forward<T>(value));
+    return future;
+}
+
+// runs f(params...) on the pool and hands back a Future that supports continuations
+template <typename F, typename... Ts>
+auto asyncOn(ThreadPool& pool, F&& f, Ts&&... params)
+{
+    using R = std::invoke_result_t<std::decay_t<F>, std::decay_t<Ts>...>;
+
+    Promise<R> promise;
+    auto future = promise.get_future();
+    pool.post([promise = std::move(promise), f = std::forward<F>(f), ... params = std::forward<Ts>(params)]() mutable {
+        detail::fulfil(promise, f, std::move(params)...);
+    });
+    return future;
+}
+
+// takes over the futures and completes once every one has, with all values in input order or the first exception
+template <std::ranges::input_range Range>
+auto when_all(Range&& futures)
+{
+    using T = decltype(std::declval<std::ranges::range_value_t<Range>>().get());
+    using Result = std::conditional_t<std::is_void_v<T>, void, std::vector<T>>;
+
+    struct Shared
+    {
+        std::vector<std::optional<detail::StoredType<T>>> values;
+        std::atomic<std::size_t> remaining;
+        std::atomic<bool> failed { false };
+        std::exception_ptr error;
+        Promise<Result> promise;
+    };
+
+    std::vector<std::ranges::range_value_t<Range>> inputs;
+    for (auto&& f : futures)
+    {
+        inputs.push_back(std::move(f));
+    }
+
+    auto shared = std::make_shared<Shared>();
+    shared->values.resize(inputs.size());
+    shared->remaining.store(inputs.size());
+    auto result = shared->promise.get_future();
+
+    auto finish = [](Shared& s) {
+        if (s.error)
+        {
+            s.promise.set_exception(s.error);
+        }
+        else if constexpr (std::is_void_v<T>)
+        {
+            s.promise.set_value();
+        }
+        else
+        {
+            std::vector<T> values;
+            values.reserve(s.values.size());
+            for (auto& v : s.values)
+            {
+                values.push_back(std::move(*v));
+            }
+            s.promise.set_value(std::move(values));
+        }
+    };
+
+    if (inputs.empty())
+    {
+        finish(*shared);
+        return result;
+    }
+
+    for (std::size_t i = 0; i < inputs.size(); ++i)
+    {
+        inputs[i].whenReady([shared, i, finish](auto ready) {
+            try
+            {
+                if constexpr (std::is_void_v<T>)
+                {
+                    ready.get();
+                }
+                else
+                {
+                    shared->values[i].emplace(ready.get());
+                }
+            }
+            catch (...)
+            {
+                if (!shared->failed.exchange(true))
+                {
+                    shared->error = std::current_exception();
+                }
+            }
+            if (shared->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                finish(*shared);
+            }
+        });
+    }
+    return result;
+}
+
+template <typename T>
+struct WhenAnyResult
+{
+    std::size_t index;
+    T value;
+};
+
+template <>
+struct WhenAnyResult<void>
+{
+    std::size_t index;
+};
+
+// takes over the futures and completes with the first one to finish, its exception included
+template <std::ranges::input_range Range>
+auto when_any(Range&& futures)
+{
+    using T = decltype(std::declval<std::ranges::range_value_t<Range>>().get());
+
+    struct Shared
+    {
+        std::atomic<bool> done { false };
+        Promise<WhenAnyResult<T>> promise;
+    };
+
+    auto shared = std::make_shared<Shared>();
+    auto result = shared->promise.get_future();
+
+    std::size_t index = 0;
+    for (auto&& f : futures)
+    {
+        std::move(f).whenReady([shared, i = index++](auto ready) {
+            if (shared->done.exchange(true))
+            {
+                return;
+            }
+            try
+            {
+                if constexpr (std::is_void_v<T>)
+                {
+                    ready.get();
+                    shared->promise.set_value(WhenAnyResult<T> { i });
+                }
+                else
+                {
+                    shared->promise.set_value(WhenAnyResult<T> { i, ready.get() });
+                }
+            }
+            catch (...)
+            {
+                shared->promise.set_exception(std::current_exception());
+            }
+        });
+    }
+    if (index == 0)
+    {
+        shared->promise.set_exception(std::make_exception_ptr(std::invalid_argument("when_any of no futures")));
+    }
+    return result;
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "StartGate.h"
+#include "Task.h"
+
+/*
+ * Lazy<T>: computed on first access, shared by every later access
+ */
+
+namespace detail
+{
+    template <typename R>
+    struct LazyResult
+    {
+        using type = R;
+    };
+
+    template <typename T>
+    struct LazyResult<Task<T>>
+    {
+        using type = T;
+    };
+
+    template <typename F>
+    using LazyResultOf = typename LazyResult<std::invoke_result_t<F&>>::type;
+}
+
+// The first caller runs the factory while concurrent first callers park on the state word;
+// once the value is there a hit costs one acquire load. If the factory throws, the state
+// goes back to empty and the next caller tries again. The factory may also be a coroutine
+// function returning Task<T>, which is then driven to completion with sync_wait.
+// F defaults to std::function, makeLazy keeps the callable inline instead.
+template <typename T, typename F = std::function<T()>>
+class Lazy
+{
+    enum : std::uint32_t { Empty, Running, Ready };
+
+    std::atomic<std::uint32_t> state { Empty };
+    F factory;
+    union
+    {
+        T value;
+    };
+
+public:
+    explicit Lazy(F f) : factory { std::move(f) } {}
+
+    ~Lazy()
+    {
+        if (state.load(std::memory_order_relaxed) == Ready)
+        {
+            value.~T();
+        }
+    }
+
+    Lazy(const Lazy&) = delete;
+    Lazy& operator=(const Lazy&) = delete;
+
+    const T& get()
+    {
+        if (state.load(std::memory_order_acquire) == Ready)
+        {
+            return value;
+        }
+        return compute();
+    }
+
+    const T& operator*() { return get(); }
+    const T* operator->() { return &get(); }
+
+    bool isReady() const noexcept { return state.load(std::memory_order_acquire) == Ready; }
+
+private:
+    const T& compute()
+    {
+        while (true)
+        {
+            auto expected = std::uint32_t { Empty };
+            if (state.compare_exchange_strong(expected, Running, std::memory_order_acquire))
+            {
+                try
+                {
+                    if constexpr (std::is_same_v<std::invoke_result_t<F&>, Task<T>>)
+                    {
+                        ::new (std::addressof(value)) T(sync_wait(factory()));
+                    }
+                    else
+                    {
+                        ::new (std::addressof(value)) T(factory());
+                    }
+                }
+                catch (...)
+                {
+                    state.store(Empty, std::memory_order_release);
+                    state.notify_all();
+                    throw;
+                }
+                state.store(Ready, std::memory_order_release);
+                state.notify_all();
+                return value;
+            }
+            if (expected == Ready)
+            {
+                return value;
+            }
+            detail::spinThenPark(state, [](std::uint32_t s) { return s != Running; });
+        }
+    }
+};
+
+template <typename F>
+Lazy<detail::LazyResultOf<std::decay_t<F>>, std::decay_t<F>> makeLazy(F&& f)
+{
+    return Lazy<detail::LazyResultOf<std::decay_t<F>>, std::decay_t<F>> { std::forward<F>(f) };
+}
@@ -0,0 +1,392 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "ThreadPool.h"
+#include "SpinWait.h"
+
+/*
+ * LightPromise/LightFuture: pooled shared state with a single atomic status word
+ */
+
+namespace detail
+{
+    // Free lists of equally sized blocks, one per thread. A block always goes back to the
+    // pool of the thread that allocated it: frees from other threads land on that pool's
+    // remote list, which the owner takes over in one exchange when its local list runs dry.
+    // Pools of finished threads are parked and adopted by new threads, never destroyed.
+    template <std::size_t Size, std::size_t Align>
+    class RecyclingPool
+    {
+        struct FreeBlock
+        {
+            FreeBlock* next;
+        };
+
+        // every block starts with a header naming its pool
+        static constexpr std::size_t headerSize = Align < sizeof(void*) ? sizeof(void*) : Align;
+        static constexpr std::size_t blockSize = headerSize + (Size < sizeof(FreeBlock) ? sizeof(FreeBlock) : Size);
+        static constexpr std::size_t maxCached = 4096;
+
+        FreeBlock* local = nullptr;
+        std::size_t cached = 0;
+        std::size_t fresh = 0;
+        std::atomic<FreeBlock*> remote { nullptr };
+        RecyclingPool* nextParked = nullptr;
+
+        struct Registry
+        {
+            std::mutex mutex;
+            RecyclingPool* parked = nullptr;
+        };
+
+        static Registry& registry()
+        {
+            static Registry r;
+            return r;
+        }
+
+        struct ThreadHandle
+        {
+            RecyclingPool* pool;
+
+            ThreadHandle()
+            {
+                auto& r = registry();
+                std::lock_guard<std::mutex> lock { r.mutex };
+                pool = r.parked ? std::exchange(r.parked, r.parked->nextParked) : new RecyclingPool;
+            }
+
+            ~ThreadHandle()
+            {
+                auto& r = registry();
+                std::lock_guard<std::mutex> lock { r.mutex };
+                pool->nextParked = std::exchange(r.parked, pool);
+            }
+        };
+
+        static RecyclingPool& current()
+        {
+            thread_local ThreadHandle handle;
+            return *handle.pool;
+        }
+
+        static RecyclingPool*& ownerOf(void* block) noexcept
+        {
+            return *reinterpret_cast<RecyclingPool**>(static_cast<unsigned char*>(block) - headerSize);
+        }
+
+    public:
+        static void* allocate()
+        {
+            auto& pool = current();
+            if (!pool.local)
+            {
+                pool.local = pool.remote.exchange(nullptr, std::memory_order_acquire);
+            }
+            if (pool.local)
+            {
+                pool.cached -= pool.cached > 0;
+                return std::exchange(pool.local, pool.local->next);
+            }
+
+            ++pool.fresh;
+            auto raw = static_cast<unsigned char*>(::operator new(blockSize, std::align_val_t { Align }));
+            auto block = raw + headerSize;
+            ownerOf(block) = &pool;
+            return block;
+        }
+
+        static void deallocate(void* block) noexcept
+        {
+            auto owner = ownerOf(block);
+            auto freed = ::new (block) FreeBlock { nullptr };
+            if (owner == &current())
+            {
+                if (owner->cached == maxCached)
+                {
+                    ::operator delete(static_cast<unsigned char*>(block) - headerSize, std::align_val_t { Align });
+                    return;
+                }
+                freed->next = std::exchange(owner->local, freed);
+                ++owner->cached;
+                return;
+            }
+
+            freed->next = owner->remote.load(std::memory_order_relaxed);
+            while (!owner->remote.compare_exchange_weak(freed->next, freed,
+                                                        std::memory_order_release, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        // how many blocks the calling thread had to get from the heap so far
+        static std::size_t freshAllocations() { return current().fresh; }
+    };
+
+    template <typename T>
+    class LightState
+    {
+        enum : std::uint32_t { Empty = 0, HasValue = 1, HasError = 2, Waiting = 4 };
+
+        // readiness and the waiter flag share one word, the producer only notifies if someone sleeps on it
+        std::atomic<std::uint32_t> status { Empty };
+        std::atomic<std::uint32_t> refs { 1 };
+        std::optional<std::conditional_t<std::is_void_v<T>, char, T>> value;
+        std::exception_ptr error;
+
+    public:
+        static LightState* create()
+        {
+            static_assert(alignof(LightState) <= alignof(std::max_align_t));
+            return ::new (allocate()) LightState;
+        }
+
+        void addRef() noexcept { refs.fetch_add(1, std::memory_order_relaxed); }
+
+        void release() noexcept
+        {
+            if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                this->~LightState();
+                RecyclingPool<sizeof(LightState), alignof(std::max_align_t)>::deallocate(this);
+            }
+        }
+
+        template <typename... Ts>
+        void setValue(Ts&&... params)
+        {
+            value.emplace(std::forward<Ts>(params)...);
+            publish(HasValue);
+        }
+
+        void setException(std::exception_ptr e) noexcept
+        {
+            error = std::move(e);
+            publish(HasError);
+        }
+
+        bool isReady() const noexcept
+        {
+            return status.load(std::memory_order_acquire) & (HasValue | HasError);
+        }
+
+        void wait() noexcept
+        {
+            for (int i = 0; i < 64; ++i)
+            {
+                if (isReady())
+                {
+                    return;
+                }
+                cpuRelax();
+            }
+            auto current = status.fetch_or(Waiting, std::memory_order_acquire) | Waiting;
+            while (!(current & (HasValue | HasError)))
+            {
+                status.wait(current, std::memory_order_acquire);
+                current = status.load(std::memory_order_acquire);
+            }
+        }
+
+        T get()
+        {
+            wait();
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+            if constexpr (!std::is_void_v<T>)
+            {
+                return std::move(*value);
+            }
+        }
+
+        static std::size_t freshAllocations()
+        {
+            return RecyclingPool<sizeof(LightState), alignof(std::max_align_t)>::freshAllocations();
+        }
+
+    private:
+        static void* allocate()
+        {
+            return RecyclingPool<sizeof(LightState), alignof(std::max_align_t)>::allocate();
+        }
+
+        void publish(std::uint32_t result) noexcept
+        {
+            if (status.exchange(result, std::memory_order_acq_rel) & Waiting)
+            {
+                status.notify_all();
+            }
+        }
+    };
+}
+
+template <typename T>
+class LightFuture
+{
+    detail::LightState<T>* state = nullptr;
+
+    template <typename U>
+    friend class LightPromise;
+
+    explicit LightFuture(detail::LightState<T>* s) noexcept : state { s } {}
+
+public:
+    LightFuture() noexcept = default;
+    LightFuture(LightFuture&& other) noexcept : state { std::exchange(other.state, nullptr) } {}
+    LightFuture& operator=(LightFuture&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            state = std::exchange(other.state, nullptr);
+        }
+        return *this;
+    }
+    LightFuture(const LightFuture&) = delete;
+    LightFuture& operator=(const LightFuture&) = delete;
+
+    ~LightFuture() { reset(); }
+
+    bool valid() const noexcept { return state != nullptr; }
+    bool isReady() const noexcept { return state->isReady(); }
+    void wait() const noexcept { state->wait(); }
+
+    T get()
+    {
+        struct Release
+        {
+            LightFuture& f;
+            ~Release() { f.reset(); }
+        } release { *this };
+        return state->get();
+    }
+
+private:
+    void reset() noexcept
+    {
+        if (state)
+        {
+            std::exchange(state, nullptr)->release();
+        }
+    }
+};
+
+template <typename T>
+class LightPromise
+{
+    detail::LightState<T>* state;
+    bool retrieved = false;
+
+public:
+    LightPromise() : state { detail::LightState<T>::create() } {}
+    LightPromise(LightPromise&& other) noexcept
+        : state { std::exchange(other.state, nullptr) }, retrieved { other.retrieved } {}
+    LightPromise& operator=(LightPromise&& other) noexcept
+    {
+        if (this != &other)
+        {
+            abandon();
+            state = std::exchange(other.state, nullptr);
+            retrieved = other.retrieved;
+        }
+        return *this;
+    }
+    LightPromise(const LightPromise&) = delete;
+    LightPromise& operator=(const LightPromise&) = delete;
+
+    ~LightPromise() { abandon(); }
+
+    LightFuture<T> get_future()
+    {
+        if (retrieved)
+        {
+            throw std::future_error(std::future_errc::future_already_retrieved);
+        }
+        retrieved = true;
+        state->addRef();
+        return LightFuture<T> { state };
+    }
+
+    // a value whose construction throws leaves the promise unsatisfied, set_exception still completes it
+    template <typename... Ts>
+    void set_value(Ts&&... params)
+    {
+        unsatisfied().setValue(std::forward<Ts>(params)...);
+        detach();
+    }
+
+    void set_exception(std::exception_ptr e)
+    {
+        unsatisfied().setException(std::move(e));
+        detach();
+    }
+
+    // heap blocks the calling thread has needed for shared states of this type so far
+    static std::size_t freshAllocations() { return detail::LightState<T>::freshAllocations(); }
+
+private:
+    detail::LightState<T>& unsatisfied()
+    {
+        if (!state)
+        {
+            throw std::future_error(std::future_errc::promise_already_satisfied);
+        }
+        return *state;
+    }
+
+    void detach() noexcept
+    {
+        std::exchange(state, nullptr)->release();
+    }
+
+    void abandon() noexcept
+    {
+        if (state)
+        {
+            auto s = std::exchange(state, nullptr);
+            s->setException(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+            s->release();
+        }
+    }
+};
+
+// like asyncOn, but the result travels through a pooled LightFuture
+template <typename F, typename... Ts>
+auto asyncLight(ThreadPool& pool, F&& f, Ts&&... params)
+{
+    using R = std::invoke_result_t<std::decay_t<F>, std::decay_t<Ts>...>;
+
+    LightPromise<R> promise;
+    auto future = promise.get_future();
+    pool.post([promise = std::move(promise), f = std::forward<F>(f), ... params = std::forward<Ts>(params)]() mutable {
+        try
+        {
+            if constexpr (std::is_void_v<R>)
+            {
+                std::invoke(f, std::move(params)...);
+                promise.set_value();
+            }
+            else
+            {
+                promise.set_value(std::invoke(f, std::move(params)...));
+            }
+        }
+        catch (...)
+        {
+            promise.set_exception(std::current_exception());
+        }
+    });
+    return future;
+}
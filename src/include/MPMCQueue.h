@@ -0,0 +1,275 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "CacheLine.h"
+
+/*
+ * Lock-free bounded multi-producer/multi-consumer ring queue
+ */
+
+// Every slot carries a turn number: ticket i may write slot i % capacity once its turn
+// is 2 * (i / capacity) and read it once the turn is one higher, so producers and
+// consumers only ever touch the shared head/tail once per operation.
+template <typename T>
+class MPMCQueue
+{
+    static_assert(std::is_nothrow_destructible_v<T>, "T must be nothrow destructible");
+
+    struct alignas(cacheLineSize) Slot
+    {
+        std::atomic<std::uint32_t> turn { 0 };
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* value() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    std::size_t capacityValue;
+    std::unique_ptr<Slot[]> slots;
+
+    alignas(cacheLineSize) std::atomic<std::size_t> head { 0 };
+    alignas(cacheLineSize) std::atomic<std::size_t> tail { 0 };
+
+public:
+    explicit MPMCQueue(std::size_t capacity) : capacityValue { capacity }
+    {
+        if (capacity == 0)
+        {
+            throw std::invalid_argument("capacity must be positive");
+        }
+        slots = std::make_unique<Slot[]>(capacity);
+    }
+
+    // must not race with any other operation
+    ~MPMCQueue()
+    {
+        for (std::size_t i = 0; i < capacityValue; ++i)
+        {
+            if (slots[i].turn.load(std::memory_order_relaxed) & 1)
+            {
+                slots[i].value()->~T();
+            }
+        }
+    }
+
+    MPMCQueue(const MPMCQueue&) = delete;
+    MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+    std::size_t capacity() const noexcept { return capacityValue; }
+
+    // a snapshot, negative while consumers are waiting for values
+    std::ptrdiff_t size() const noexcept
+    {
+        return static_cast<std::ptrdiff_t>(head.load(std::memory_order_relaxed)
+                                         - tail.load(std::memory_order_relaxed));
+    }
+
+    bool empty() const noexcept { return size() <= 0; }
+
+    template <typename... Ts>
+    bool try_emplace(Ts&&... params)
+    {
+        auto ticket = head.load(std::memory_order_acquire);
+        while (true)
+        {
+            auto& slot = slots[index(ticket)];
+            if (slot.turn.load(std::memory_order_acquire) == writeTurn(ticket))
+            {
+                if (head.compare_exchange_strong(ticket, ticket + 1))
+                {
+                    write(slot, ticket, std::forward<Ts>(params)...);
+                    return true;
+                }
+            }
+            else
+            {
+                auto previous = ticket;
+                ticket = head.load(std::memory_order_acquire);
+                if (ticket == previous)
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    bool try_push(const T& value) { return try_emplace(value); }
+    bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+    bool try_pop(T& out)
+    {
+        auto ticket = tail.load(std::memory_order_acquire);
+        while (true)
+        {
+            auto& slot = slots[index(ticket)];
+            if (slot.turn.load(std::memory_order_acquire) == readTurn(ticket))
+            {
+                if (tail.compare_exchange_strong(ticket, ticket + 1))
+                {
+                    out = read(slot, ticket);
+                    return true;
+                }
+            }
+            else
+            {
+                auto previous = ticket;
+                ticket = tail.load(std::memory_order_acquire);
+                if (ticket == previous)
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    // blocking variants park on the slot's turn until it is their go
+    template <typename... Ts>
+    void emplace(Ts&&... params)
+    {
+        auto ticket = head.fetch_add(1);
+        auto& slot = slots[index(ticket)];
+        waitForTurn(slot, writeTurn(ticket));
+        write(slot, ticket, std::forward<Ts>(params)...);
+    }
+
+    void push(const T& value) { emplace(value); }
+    void push(T&& value) { emplace(std::move(value)); }
+
+    T pop()
+    {
+        auto ticket = tail.fetch_add(1);
+        auto& slot = slots[index(ticket)];
+        waitForTurn(slot, readTurn(ticket));
+        return read(slot, ticket);
+    }
+
+    // batch variants claim all their tickets with a single update of head/tail
+    template <typename InputIt>
+    void push_n(InputIt first, std::size_t count)
+    {
+        auto ticket = head.fetch_add(count);
+        for (std::size_t i = 0; i < count; ++i, ++first, ++ticket)
+        {
+            auto& slot = slots[index(ticket)];
+            waitForTurn(slot, writeTurn(ticket));
+            write(slot, ticket, *first);
+        }
+    }
+
+    template <typename OutputIt>
+    OutputIt pop_n(OutputIt out, std::size_t count)
+    {
+        auto ticket = tail.fetch_add(count);
+        for (std::size_t i = 0; i < count; ++i, ++ticket)
+        {
+            auto& slot = slots[index(ticket)];
+            waitForTurn(slot, readTurn(ticket));
+            *out++ = read(slot, ticket);
+        }
+        return out;
+    }
+
+    // pushes as many values as there is free space for, returns how many were taken
+    template <typename InputIt>
+    std::size_t try_push_n(InputIt first, std::size_t count)
+    {
+        auto ticket = head.load(std::memory_order_acquire);
+        std::size_t claimed;
+        do
+        {
+            auto used = static_cast<std::ptrdiff_t>(ticket - tail.load(std::memory_order_acquire));
+            auto free = static_cast<std::ptrdiff_t>(capacityValue) - std::max<std::ptrdiff_t>(used, 0);
+            claimed = std::min(count, static_cast<std::size_t>(std::max<std::ptrdiff_t>(free, 0)));
+            if (claimed == 0)
+            {
+                return 0;
+            }
+        }
+        while (!head.compare_exchange_weak(ticket, ticket + claimed));
+
+        // the previous occupants of these slots are already claimed by consumers, so waits are short
+        for (std::size_t i = 0; i < claimed; ++i, ++first, ++ticket)
+        {
+            auto& slot = slots[index(ticket)];
+            waitForTurn(slot, writeTurn(ticket));
+            write(slot, ticket, *first);
+        }
+        return claimed;
+    }
+
+    // pops up to count values that producers have already claimed, returns how many were popped
+    template <typename OutputIt>
+    std::size_t try_pop_n(OutputIt out, std::size_t count)
+    {
+        auto ticket = tail.load(std::memory_order_acquire);
+        std::size_t claimed;
+        do
+        {
+            auto available = static_cast<std::ptrdiff_t>(head.load(std::memory_order_acquire) - ticket);
+            claimed = std::min(count, static_cast<std::size_t>(std::max<std::ptrdiff_t>(available, 0)));
+            if (claimed == 0)
+            {
+                return 0;
+            }
+        }
+        while (!tail.compare_exchange_weak(ticket, ticket + claimed));
+
+        for (std::size_t i = 0; i < claimed; ++i, ++ticket)
+        {
+            auto& slot = slots[index(ticket)];
+            waitForTurn(slot, readTurn(ticket));
+            *out++ = read(slot, ticket);
+        }
+        return claimed;
+    }
+
+private:
+    std::size_t index(std::size_t ticket) const noexcept { return ticket % capacityValue; }
+
+    // turns only ever get compared for equality, so wrapping around 32 bits is harmless
+    std::uint32_t writeTurn(std::size_t ticket) const noexcept
+    {
+        return static_cast<std::uint32_t>(ticket / capacityValue * 2);
+    }
+    std::uint32_t readTurn(std::size_t ticket) const noexcept
+    {
+        return writeTurn(ticket) + 1;
+    }
+
+    static void waitForTurn(Slot& slot, std::uint32_t turn) noexcept
+    {
+        auto current = slot.turn.load(std::memory_order_acquire);
+        while (current != turn)
+        {
+            slot.turn.wait(current, std::memory_order_acquire);
+            current = slot.turn.load(std::memory_order_acquire);
+        }
+    }
+
+    template <typename... Ts>
+    void write(Slot& slot, std::size_t ticket, Ts&&... params)
+    {
+        // a throwing constructor would leave a claimed ticket behind that nobody ever fills
+        static_assert(std::is_nothrow_constructible_v<T, Ts&&...>, "T must be nothrow constructible from the arguments");
+        ::new (static_cast<void*>(slot.storage)) T(std::forward<Ts>(params)...);
+        slot.turn.store(readTurn(ticket), std::memory_order_release);
+        slot.turn.notify_all();
+    }
+
+    T read(Slot& slot, std::size_t ticket)
+    {
+        T value { std::move(*slot.value()) };
+        slot.value()->~T();
+        slot.turn.store(writeTurn(ticket) + 2, std::memory_order_release);
+        slot.turn.notify_all();
+        return value;
+    }
+};
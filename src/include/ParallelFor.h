@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ThreadPool.h"
+
+/*
+ * Chunked parallel_for / parallel_transform over an index range
+ */
+
+namespace detail
+{
+    // several chunks per worker let fast workers pick up the slack of slow ones,
+    // while the lower bound keeps tiny bodies from drowning in scheduling overhead
+    inline std::size_t defaultGrain(std::size_t count, std::size_t workers) noexcept
+    {
+        constexpr std::size_t minGrain = 1024;
+        constexpr std::size_t chunksPerWorker = 8;
+        auto chunks = workers * chunksPerWorker;
+        return std::max(minGrain, (count + chunks - 1) / chunks);
+    }
+
+    struct ParallelForState
+    {
+        std::size_t begin;
+        std::size_t end;
+        std::size_t grain;
+        std::size_t numChunks;
+
+        void (*body)(void*, std::size_t, std::size_t);
+        void* context;
+
+        std::atomic<std::size_t> nextChunk { 0 };
+        std::atomic<std::size_t> doneChunks { 0 };
+        std::atomic<bool> failed { false };
+        std::exception_ptr error;
+
+        // helpers may start after the loop is finished, they only touch
+        // body/context once they have claimed a chunk
+        void runChunks() noexcept
+        {
+            std::size_t chunk;
+            while ((chunk = nextChunk.fetch_add(1, std::memory_order_relaxed)) < numChunks)
+            {
+                auto first = begin + chunk * grain;
+                auto last = std::min(first + grain, end);
+                if (!failed.load(std::memory_order_relaxed))
+                {
+                    try
+                    {
+                        body(context, first, last);
+                    }
+                    catch (...)
+                    {
+                        if (!failed.exchange(true))
+                        {
+                            error = std::current_exception();
+                        }
+                    }
+                }
+                if (doneChunks.fetch_add(1, std::memory_order_acq_rel) + 1 == numChunks)
+                {
+                    doneChunks.notify_all();
+                }
+            }
+        }
+
+        void wait() noexcept
+        {
+            auto done = doneChunks.load(std::memory_order_acquire);
+            while (done != numChunks)
+            {
+                doneChunks.wait(done, std::memory_order_acquire);
+                done = doneChunks.load(std::memory_order_acquire);
+            }
+        }
+    };
+}
+
+// calls f(i) for every i in [begin, end), grain == 0 picks the chunk size automatically
+template <typename F>
+void parallel_for(ThreadPool& pool, std::size_t begin, std::size_t end, std::size_t grain, F&& f)
+{
+    if (begin >= end)
+    {
+        return;
+    }
+    auto count = end - begin;
+    if (grain == 0)
+    {
+        grain = detail::defaultGrain(count, pool.size());
+    }
+
+    auto runRange = [](void* context, std::size_t first, std::size_t last)
+    {
+        auto& fn = *static_cast<std::remove_reference_t<F>*>(context);
+        for (auto i = first; i < last; ++i)
+        {
+            std::invoke(fn, i);
+        }
+    };
+
+    auto numChunks = (count + grain - 1) / grain;
+    if (numChunks == 1)
+    {
+        runRange(&f, begin, end);
+        return;
+    }
+
+    auto state = std::make_shared<detail::ParallelForState>();
+    state->begin = begin;
+    state->end = end;
+    state->grain = grain;
+    state->numChunks = numChunks;
+    state->body = runRange;
+    state->context = const_cast<void*>(static_cast<const void*>(std::addressof(f)));
+
+    // the calling thread works too, so at most numChunks - 1 helpers are useful
+    auto numHelpers = std::min(pool.size(), numChunks - 1);
+    for (std::size_t i = 0; i < numHelpers; ++i)
+    {
+        pool.post([state]() { state->runChunks(); });
+    }
+
+    state->runChunks();
+    state->wait();
+
+    if (state->error)
+    {
+        std::rethrow_exception(state->error);
+    }
+}
+
+template <typename F>
+void parallel_for(std::size_t begin, std::size_t end, std::size_t grain, F&& f)
+{
+    parallel_for(defaultThreadPool(), begin, end, grain, std::forward<F>(f));
+}
+
+// results are written straight into a preallocated vector, one slot per index
+template <typename F>
+auto parallel_transform(ThreadPool& pool, std::size_t begin, std::size_t end, std::size_t grain, F&& f)
+{
+    using R = std::invoke_result_t<F&, std::size_t>;
+
+    std::vector<R> results(end > begin ? end - begin : 0);
+    parallel_for(pool, begin, end, grain, [&results, &f, begin](std::size_t i) {
+        results[i - begin] = std::invoke(f, i);
+    });
+    return results;
+}
+
+template <typename F>
+auto parallel_transform(std::size_t begin, std::size_t end, std::size_t grain, F&& f)
+{
+    return parallel_transform(defaultThreadPool(), begin, end, grain, std::forward<F>(f));
+}
@@ -0,0 +1,299 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ThreadPool.h"
+#include "LightFuture.h"
+#include "Snapshot.h"
+
+/*
+ * Executor with priority lanes, earliest-deadline-first within a lane and aging across lanes
+ */
+
+enum class TaskPriority { High, Normal, Low };
+
+struct TaskOptions
+{
+    TaskPriority priority = TaskPriority::Normal;
+    std::optional<std::chrono::steady_clock::time_point> deadline = std::nullopt;
+};
+
+struct DeadlineMiss
+{
+    TaskPriority priority;
+    std::chrono::steady_clock::duration lateness; // how long after the deadline the task finished
+};
+
+// Every lane is a heap ordered by deadline; a task without one gets an implicit deadline of
+// enqueue time + numLanes * agingInterval, so it can not starve behind a stream of deadlines.
+// Across lanes a lane moves up one lane per agingInterval its oldest task has waited, ties
+// go to the lane whose oldest task was queued first; the lane that wins runs its heap head.
+// A task that finishes after its deadline is counted and handed to the miss handler before
+// its future is completed.
+class PriorityExecutor
+{
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr std::size_t numLanes = 3;
+
+    struct Entry
+    {
+        Clock::time_point key;
+        std::uint64_t sequence;
+        detail::Job job;
+    };
+
+    // std heaps keep the largest element in front, so "larger" means due later
+    struct DueLater
+    {
+        bool operator()(const Entry& a, const Entry& b) const noexcept
+        {
+            return a.key != b.key ? a.key > b.key : a.sequence > b.sequence;
+        }
+    };
+
+    struct Lane
+    {
+        std::vector<Entry> heap;
+        // enqueue time of every queued task by sequence, the first one is the oldest waiter
+        std::map<std::uint64_t, Clock::time_point> waiting;
+    };
+
+    using MissHandler = std::function<void(const DeadlineMiss&)>;
+
+    Clock::duration agingInterval;
+
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::array<Lane, numLanes> lanes;
+    std::uint64_t nextSequence = 0;
+    bool stopping = false;
+
+    std::array<std::atomic<std::uint64_t>, numLanes> misses {};
+    Snapshot<MissHandler> missHandler { std::in_place };
+
+    std::vector<std::thread> threads;
+
+public:
+    explicit PriorityExecutor(std::size_t numThreads = std::max(1u, std::thread::hardware_concurrency()),
+                              Clock::duration aging = std::chrono::milliseconds(10))
+        : agingInterval { aging }
+    {
+        if (aging <= Clock::duration::zero())
+        {
+            throw std::invalid_argument("aging interval must be positive");
+        }
+        for (std::size_t i = 0; i < numThreads; ++i)
+        {
+            threads.emplace_back(&PriorityExecutor::run, this);
+        }
+    }
+
+    // runs what is still queued, then joins
+    ~PriorityExecutor()
+    {
+        {
+            std::lock_guard<std::mutex> lock { mutex };
+            stopping = true;
+        }
+        workAvailable.notify_all();
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+    }
+
+    PriorityExecutor(const PriorityExecutor&) = delete;
+    PriorityExecutor& operator=(const PriorityExecutor&) = delete;
+
+    // runs on the worker that finished late; may be replaced while tasks run
+    void onDeadlineMiss(MissHandler handler)
+    {
+        missHandler.publish(std::make_shared<const MissHandler>(std::move(handler)));
+    }
+
+    std::uint64_t deadlineMisses(TaskPriority priority) const noexcept
+    {
+        return misses[static_cast<std::size_t>(priority)].load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t deadlineMisses() const noexcept
+    {
+        std::uint64_t total = 0;
+        for (auto& m : misses)
+        {
+            total += m.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    template <typename F>
+    void post(const TaskOptions& options, F&& f)
+    {
+        enqueue(options, [this, options, f = std::forward<F>(f)]() mutable {
+            f();
+            recordFinish(options);
+        });
+    }
+
+    // asyncTask with options: f(params...) runs according to them, the result comes back in a LightFuture
+    template <typename F, typename... Ts>
+    auto submit(const TaskOptions& options, F&& f, Ts&&... params)
+    {
+        using R = std::invoke_result_t<std::decay_t<F>, std::decay_t<Ts>...>;
+
+        LightPromise<R> promise;
+        auto future = promise.get_future();
+        // the miss is recorded once, after f and before the future completes, so a caller returning
+        // from get() sees it; a throwing miss handler fails a task that would otherwise have succeeded
+        enqueue(options, [this, options, promise = std::move(promise), f = std::forward<F>(f),
+                          ... params = std::forward<Ts>(params)]() mutable {
+            std::optional<std::conditional_t<std::is_void_v<R>, char, R>> value;
+            std::exception_ptr error;
+            try
+            {
+                if constexpr (std::is_void_v<R>)
+                {
+                    std::invoke(f, std::move(params)...);
+                }
+                else
+                {
+                    value.emplace(std::invoke(f, std::move(params)...));
+                }
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            try
+            {
+                recordFinish(options);
+                if (!error)
+                {
+                    if constexpr (std::is_void_v<R>)
+                    {
+                        promise.set_value();
+                    }
+                    else
+                    {
+                        promise.set_value(std::move(*value));
+                    }
+                    return;
+                }
+            }
+            catch (...)
+            {
+                error = error ? error : std::current_exception();
+            }
+            promise.set_exception(error);
+        });
+        return future;
+    }
+
+private:
+    void enqueue(const TaskOptions& options, detail::Job job)
+    {
+        auto laneIndex = static_cast<std::size_t>(options.priority);
+        {
+            std::lock_guard<std::mutex> lock { mutex };
+            auto now = Clock::now();
+            auto key = options.deadline.value_or(now + agingInterval * static_cast<Clock::rep>(numLanes));
+            auto& lane = lanes[laneIndex];
+            lane.heap.push_back(Entry { key, nextSequence, std::move(job) });
+            std::push_heap(lane.heap.begin(), lane.heap.end(), DueLater {});
+            lane.waiting.emplace_hint(lane.waiting.end(), nextSequence, now);
+            ++nextSequence;
+        }
+        workAvailable.notify_one();
+    }
+
+    void recordFinish(const TaskOptions& options)
+    {
+        if (!options.deadline)
+        {
+            return;
+        }
+        auto finished = Clock::now();
+        if (finished > *options.deadline)
+        {
+            misses[static_cast<std::size_t>(options.priority)].fetch_add(1, std::memory_order_relaxed);
+            auto handler = missHandler.load();
+            if (*handler)
+            {
+                (*handler)(DeadlineMiss { options.priority, finished - *options.deadline });
+            }
+        }
+    }
+
+    // callers hold the mutex and have checked that some lane is not empty
+    Entry takeNext(Clock::time_point now)
+    {
+        std::size_t best = numLanes;
+        std::int64_t bestEffective = 0;
+        std::uint64_t bestOldest = 0;
+        for (std::size_t lane = 0; lane < numLanes; ++lane)
+        {
+            if (lanes[lane].heap.empty())
+            {
+                continue;
+            }
+            auto [oldest, enqueued] = *lanes[lane].waiting.begin();
+            auto aged = static_cast<std::int64_t>((now - enqueued) / agingInterval);
+            auto effective = std::max<std::int64_t>(0, static_cast<std::int64_t>(lane) - aged);
+            if (best == numLanes || effective < bestEffective || (effective == bestEffective && oldest < bestOldest))
+            {
+                best = lane;
+                bestEffective = effective;
+                bestOldest = oldest;
+            }
+        }
+
+        auto& lane = lanes[best];
+        std::pop_heap(lane.heap.begin(), lane.heap.end(), DueLater {});
+        auto entry = std::move(lane.heap.back());
+        lane.heap.pop_back();
+        lane.waiting.erase(entry.sequence);
+        return entry;
+    }
+
+    bool empty() const noexcept
+    {
+        return std::all_of(lanes.begin(), lanes.end(), [](const Lane& lane) { return lane.heap.empty(); });
+    }
+
+    void run()
+    {
+        while (true)
+        {
+            Entry entry;
+            {
+                std::unique_lock<std::mutex> lock { mutex };
+                workAvailable.wait(lock, [this] { return stopping || !empty(); });
+                if (empty())
+                {
+                    return;
+                }
+                entry = takeNext(Clock::now());
+            }
+
+            entry.job();
+        }
+    }
+};
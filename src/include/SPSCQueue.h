@@ -0,0 +1,274 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "CacheLine.h"
+#include "SpinWait.h"
+
+/*
+ * Wait-free bounded single-producer/single-consumer ring queue
+ */
+
+// Each side owns one index and keeps a private copy of the other one, so it only reads the
+// other side's index when the copy says there is not enough room (or not enough items). The try_ operations are
+// wait-free; push/pop block with backpressure once the ring is full (or empty).
+// The lowest bit of the producer's word marks the queue as closed.
+template <typename T>
+class SPSCQueue
+{
+    static_assert(std::is_nothrow_destructible_v<T>, "T must be nothrow destructible");
+    static_assert(std::is_nothrow_move_constructible_v<T>, "T must be nothrow move constructible");
+
+    static constexpr int spinLimit = 64;
+
+    struct Slot
+    {
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        T* value() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    std::size_t mask;
+    std::unique_ptr<Slot[]> slots;
+
+    // producer side: pushed count << 1 | closed
+    alignas(cacheLineSize) std::atomic<std::size_t> tail { 0 };
+    std::size_t cachedHead = 0;
+
+    // consumer side: popped count
+    alignas(cacheLineSize) std::atomic<std::size_t> head { 0 };
+    std::size_t cachedTail = 0;
+
+public:
+    // the capacity is rounded up to a power of two
+    explicit SPSCQueue(std::size_t capacity)
+    {
+        if (capacity == 0)
+        {
+            throw std::invalid_argument("capacity must be positive");
+        }
+        mask = std::bit_ceil(capacity) - 1;
+        slots = std::make_unique<Slot[]>(mask + 1);
+    }
+
+    ~SPSCQueue()
+    {
+        auto pushed = tail.load(std::memory_order_relaxed) >> 1;
+        for (auto i = head.load(std::memory_order_relaxed); i != pushed; ++i)
+        {
+            slots[i & mask].value()->~T();
+        }
+    }
+
+    SPSCQueue(const SPSCQueue&) = delete;
+    SPSCQueue& operator=(const SPSCQueue&) = delete;
+
+    std::size_t capacity() const noexcept { return mask + 1; }
+
+    /*
+     * Producer
+     */
+
+    template <typename... Ts>
+    bool try_emplace(Ts&&... params)
+    {
+        auto pushed = tail.load(std::memory_order_relaxed) >> 1;
+        if (freeSlots(pushed) == 0)
+        {
+            return false;
+        }
+        ::new (slots[pushed & mask].storage) T(std::forward<Ts>(params)...);
+        tail.store((pushed + 1) << 1, std::memory_order_release);
+        tail.notify_one();
+        return true;
+    }
+
+    bool try_push(const T& value) { return try_emplace(value); }
+    bool try_push(T&& value) { return try_emplace(std::move(value)); }
+
+    // moves or copies as many of [first, first + count) as fit with one publication, returns how many;
+    // if constructing one throws, the ones built so far are destroyed and nothing is pushed
+    template <typename It>
+    std::size_t try_push_n(It first, std::size_t count)
+    {
+        auto pushed = tail.load(std::memory_order_relaxed) >> 1;
+        auto n = std::min(count, freeSlots(pushed, count));
+        std::size_t built = 0;
+        try
+        {
+            for (; built < n; ++built, ++first)
+            {
+                ::new (slots[(pushed + built) & mask].storage) T(*first);
+            }
+        }
+        catch (...)
+        {
+            for (std::size_t i = 0; i < built; ++i)
+            {
+                slots[(pushed + i) & mask].value()->~T();
+            }
+            throw;
+        }
+        if (n > 0)
+        {
+            tail.store((pushed + n) << 1, std::memory_order_release);
+            tail.notify_one();
+        }
+        return n;
+    }
+
+    template <typename... Ts>
+    void emplace(Ts&&... params)
+    {
+        while (!try_emplace(std::forward<Ts>(params)...))
+        {
+            waitForSpace();
+        }
+    }
+
+    void push(const T& value) { emplace(value); }
+    void push(T&& value) { emplace(std::move(value)); }
+
+    template <typename It>
+    void push_n(It first, std::size_t count)
+    {
+        while (count > 0)
+        {
+            auto n = try_push_n(first, count);
+            std::advance(first, n);
+            count -= n;
+            if (count > 0)
+            {
+                waitForSpace();
+            }
+        }
+    }
+
+    // no more pushes, the consumer drains what is left and then sees the end
+    void close() noexcept
+    {
+        tail.fetch_or(1, std::memory_order_release);
+        tail.notify_one();
+    }
+
+    /*
+     * Consumer
+     */
+
+    bool try_pop(T& value)
+    {
+        return try_pop_n(&value, 1) == 1;
+    }
+
+    // moves up to maxCount values to out with one publication, returns how many
+    template <typename OutIt>
+    std::size_t try_pop_n(OutIt out, std::size_t maxCount)
+    {
+        auto popped = head.load(std::memory_order_relaxed);
+        auto n = std::min(maxCount, availableItems(popped, maxCount));
+        for (std::size_t i = 0; i < n; ++i, ++out)
+        {
+            auto value = slots[(popped + i) & mask].value();
+            *out = std::move(*value);
+            value->~T();
+        }
+        if (n > 0)
+        {
+            head.store(popped + n, std::memory_order_release);
+            head.notify_one();
+        }
+        return n;
+    }
+
+    // false once the queue is closed and drained
+    bool pop(T& value)
+    {
+        return pop_n(&value, 1) == 1;
+    }
+
+    // blocks until at least one value is there, 0 means closed and drained
+    template <typename OutIt>
+    std::size_t pop_n(OutIt out, std::size_t maxCount)
+    {
+        while (true)
+        {
+            if (auto n = try_pop_n(out, maxCount))
+            {
+                return n;
+            }
+            if (!waitForItems())
+            {
+                return 0;
+            }
+        }
+    }
+
+private:
+    // the shared index is only read when the cached one can not satisfy the request
+    std::size_t freeSlots(std::size_t pushed, std::size_t wanted = 1) noexcept
+    {
+        if (capacity() - (pushed - cachedHead) < wanted)
+        {
+            cachedHead = head.load(std::memory_order_acquire);
+        }
+        return capacity() - (pushed - cachedHead);
+    }
+
+    std::size_t availableItems(std::size_t popped, std::size_t wanted = 1) noexcept
+    {
+        if ((cachedTail >> 1) - popped < wanted)
+        {
+            cachedTail = tail.load(std::memory_order_acquire);
+        }
+        return (cachedTail >> 1) - popped;
+    }
+
+    void waitForSpace() noexcept
+    {
+        auto pushed = tail.load(std::memory_order_relaxed) >> 1;
+        for (int i = 0; i < spinLimit; ++i)
+        {
+            if (pushed - head.load(std::memory_order_acquire) <= mask)
+            {
+                return;
+            }
+            cpuRelax();
+        }
+        auto current = head.load(std::memory_order_acquire);
+        while (pushed - current > mask)
+        {
+            head.wait(current, std::memory_order_acquire);
+            current = head.load(std::memory_order_acquire);
+        }
+    }
+
+    // false if the queue is closed and nothing more will come
+    bool waitForItems() noexcept
+    {
+        auto popped = head.load(std::memory_order_relaxed);
+        auto hasWork = [popped](std::size_t word) { return (word >> 1) != popped || (word & 1); };
+        for (int i = 0; i < spinLimit; ++i)
+        {
+            if (hasWork(tail.load(std::memory_order_acquire)))
+            {
+                break;
+            }
+            cpuRelax();
+        }
+        auto current = tail.load(std::memory_order_acquire);
+        while (!hasWork(current))
+        {
+            tail.wait(current, std::memory_order_acquire);
+            current = tail.load(std::memory_order_acquire);
+        }
+        return (current >> 1) != popped;
+    }
+};
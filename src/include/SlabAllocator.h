@@ -0,0 +1,193 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+/*
+ * Slab node pool and the allocators that draw from it
+ */
+
+// Hands out small blocks carved from large slabs, with one free list per 16-byte size class;
+// a freed block goes on the free list of its class and is reused before the slab grows.
+// Bigger or over-aligned requests go straight to operator new. Slab memory is given back only
+// when the pool is destroyed, so the pool has to outlive every container drawing from it.
+// Like the containers it serves it is not thread-safe.
+class SlabPool
+{
+    static constexpr std::size_t granularity = 16;
+    static constexpr std::size_t numClasses = 16; // blocks of up to 256 bytes
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    std::size_t slabBytes;
+    std::vector<std::unique_ptr<std::byte[]>> slabs;
+    std::byte* cursor = nullptr;
+    std::byte* slabEnd = nullptr;
+    std::array<FreeBlock*, numClasses> freeLists {};
+    std::size_t liveBlocks = 0;
+
+public:
+    explicit SlabPool(std::size_t slabBytes = 1 << 20) : slabBytes { std::max(slabBytes, granularity * numClasses) } {}
+
+    SlabPool(const SlabPool&) = delete;
+    SlabPool& operator=(const SlabPool&) = delete;
+
+    void* allocate(std::size_t bytes, std::size_t alignment)
+    {
+        if (bytes == 0 || bytes > granularity * numClasses || alignment > granularity)
+        {
+            return ::operator new(bytes, std::align_val_t { std::max(alignment, alignof(std::max_align_t)) });
+        }
+
+        ++liveBlocks;
+        auto sizeClass = (bytes - 1) / granularity;
+        if (auto block = freeLists[sizeClass])
+        {
+            freeLists[sizeClass] = block->next;
+            return block;
+        }
+
+        auto blockBytes = (sizeClass + 1) * granularity;
+        if (static_cast<std::size_t>(slabEnd - cursor) < blockBytes)
+        {
+            // the tail of the old slab is left unused
+            slabs.push_back(std::make_unique_for_overwrite<std::byte[]>(slabBytes));
+            cursor = slabs.back().get();
+            slabEnd = cursor + slabBytes;
+        }
+        auto block = cursor;
+        cursor += blockBytes;
+        return block;
+    }
+
+    void deallocate(void* p, std::size_t bytes, std::size_t alignment) noexcept
+    {
+        if (bytes == 0 || bytes > granularity * numClasses || alignment > granularity)
+        {
+            ::operator delete(p, std::align_val_t { std::max(alignment, alignof(std::max_align_t)) });
+            return;
+        }
+
+        --liveBlocks;
+        auto sizeClass = (bytes - 1) / granularity;
+        freeLists[sizeClass] = ::new (p) FreeBlock { freeLists[sizeClass] };
+    }
+
+    // heap memory taken for slabs so far
+    std::size_t reservedBytes() const noexcept { return slabs.size() * slabBytes; }
+
+    // blocks handed out from slabs and not given back yet
+    std::size_t blocksInUse() const noexcept { return liveBlocks; }
+};
+
+// Standard allocator over a SlabPool; rebound copies (allocate_shared rebinds to its control
+// block type) share the pool.
+template <typename T>
+class SlabAllocator
+{
+    SlabPool* pool;
+
+    template <typename U>
+    friend class SlabAllocator;
+
+public:
+    using value_type = T;
+
+    explicit SlabAllocator(SlabPool& pool) noexcept : pool { &pool } {}
+
+    template <typename U>
+    SlabAllocator(const SlabAllocator<U>& other) noexcept : pool { other.pool } {}
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(pool->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        pool->deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    template <typename U>
+    bool operator==(const SlabAllocator<U>& other) const noexcept
+    {
+        return pool == other.pool;
+    }
+};
+
+struct AllocationCounters
+{
+    std::size_t allocations = 0;
+    std::size_t bytes = 0;     // currently allocated
+    std::size_t peakBytes = 0;
+    // the same including what malloc adds per block, header and rounding
+    std::size_t footprintBytes = 0;
+    std::size_t peakFootprintBytes = 0;
+};
+
+namespace detail
+{
+    // heap memory a block really takes; outside glibc, a one-word header rounded to max_align_t
+    inline std::size_t heapFootprint([[maybe_unused]] void* p, [[maybe_unused]] std::size_t bytes) noexcept
+    {
+#if defined(__GLIBC__)
+        return malloc_usable_size(p) + sizeof(std::size_t);
+#else
+        constexpr auto alignment = alignof(std::max_align_t);
+        return (bytes + sizeof(std::size_t) + alignment - 1) / alignment * alignment;
+#endif
+    }
+}
+
+// std::allocator that records what it hands out in the counters it was made with
+template <typename T>
+class CountingAllocator
+{
+    AllocationCounters* counters;
+
+    template <typename U>
+    friend class CountingAllocator;
+
+public:
+    using value_type = T;
+
+    explicit CountingAllocator(AllocationCounters& counters) noexcept : counters { &counters } {}
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other) noexcept : counters { other.counters } {}
+
+    T* allocate(std::size_t n)
+    {
+        auto p = std::allocator<T> {}.allocate(n);
+        ++counters->allocations;
+        counters->bytes += n * sizeof(T);
+        counters->peakBytes = std::max(counters->peakBytes, counters->bytes);
+        counters->footprintBytes += detail::heapFootprint(p, n * sizeof(T));
+        counters->peakFootprintBytes = std::max(counters->peakFootprintBytes, counters->footprintBytes);
+        return p;
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        counters->bytes -= n * sizeof(T);
+        counters->footprintBytes -= detail::heapFootprint(p, n * sizeof(T));
+        std::allocator<T> {}.deallocate(p, n);
+    }
+
+    template <typename U>
+    bool operator==(const CountingAllocator<U>& other) const noexcept
+    {
+        return counters == other.counters;
+    }
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+/*
+ * Snapshot<T>: read-copy-update publication of immutable versions
+ */
+
+// Readers get the current version as a shared_ptr<const T>, which keeps that version alive
+// for as long as they hold it no matter how often it is replaced in the meantime.
+// Writers never modify a published version: they build a new one and swap it in.
+template <typename T>
+class Snapshot
+{
+public:
+    using Pin = std::shared_ptr<const T>;
+
+private:
+    std::atomic<Pin> current;
+
+public:
+    explicit Snapshot(Pin initial) : current { std::move(initial) } {}
+
+    template <typename... Ts>
+    explicit Snapshot(std::in_place_t, Ts&&... params)
+        : current { std::make_shared<const T>(std::forward<Ts>(params)...) }
+    {
+    }
+
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    Pin load() const noexcept
+    {
+        return current.load(std::memory_order_acquire);
+    }
+
+    // replaces the version unconditionally, returns the one it replaced
+    Pin publish(Pin next) noexcept
+    {
+        return current.exchange(std::move(next), std::memory_order_acq_rel);
+    }
+
+    // Copy-on-write: fn either edits a private copy through T& or builds the next version
+    // from const T& and returns it as a shared_ptr (for types that can not be copied).
+    // If another writer got in first fn runs again on the newer version, so it must not
+    // have side effects. Returns the version that was published.
+    template <typename F>
+    Pin update(F&& fn)
+    {
+        auto expected = load();
+        while (true)
+        {
+            auto next = makeNext(fn, *expected);
+            if (current.compare_exchange_weak(expected, next, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                return next;
+            }
+        }
+    }
+
+private:
+    template <typename F>
+    static Pin makeNext(F& fn, const T& base)
+    {
+        if constexpr (std::is_invocable_r_v<Pin, F&, const T&>)
+        {
+            return std::invoke(fn, base);
+        }
+        else
+        {
+            auto copy = std::make_shared<T>(base);
+            std::invoke(fn, *copy);
+            return copy;
+        }
+    }
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+#include "SpinWait.h"
+
+/*
+ * Event and StartGate built on std::atomic::wait (a futex on Linux)
+ */
+
+namespace detail
+{
+    // a short spin catches wake-ups that are about to happen, after that the thread parks
+    constexpr int spinLimit = 128;
+
+    template <typename Pred>
+    void spinThenPark(const std::atomic<std::uint32_t>& word, Pred done) noexcept
+    {
+        for (int i = 0; i < spinLimit; ++i)
+        {
+            if (done(word.load(std::memory_order_acquire)))
+            {
+                return;
+            }
+            cpuRelax();
+        }
+        auto current = word.load(std::memory_order_acquire);
+        while (!done(current))
+        {
+            word.wait(current, std::memory_order_acquire);
+            current = word.load(std::memory_order_acquire);
+        }
+    }
+
+    // Counts the calls still running inside an object. A waiter often destroys what it waited
+    // on as soon as it returns, while the call that released it is still inside notify; the
+    // owner's destructor drains the count first, as TaskGraph does with its finisher.
+    class CallsInside
+    {
+        std::atomic<std::uint32_t> calls { 0 };
+
+    public:
+        class Scope
+        {
+            CallsInside& owner;
+
+        public:
+            // counted before anything the call publishes, so whoever sees that also sees the call
+            explicit Scope(CallsInside& o) noexcept : owner { o }
+            {
+                owner.calls.fetch_add(1, std::memory_order_relaxed);
+            }
+            ~Scope() { owner.calls.fetch_sub(1, std::memory_order_release); }
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+        };
+
+        void drain() const noexcept
+        {
+            while (calls.load(std::memory_order_acquire) != 0)
+            {
+                std::this_thread::yield();
+            }
+        }
+    };
+}
+
+// manual-reset event
+class Event
+{
+    std::atomic<std::uint32_t> state { 0 };
+    detail::CallsInside setting;
+
+public:
+    // a waiter may destroy the event once wait() returns, a set() still notifying is waited out
+    ~Event() { setting.drain(); }
+
+    void set() noexcept
+    {
+        detail::CallsInside::Scope scope { setting };
+        state.store(1, std::memory_order_release);
+        state.notify_all();
+    }
+
+    void reset() noexcept
+    {
+        state.store(0, std::memory_order_relaxed);
+    }
+
+    bool isSet() const noexcept
+    {
+        return state.load(std::memory_order_acquire) == 1;
+    }
+
+    void wait() const noexcept
+    {
+        detail::spinThenPark(state, [](std::uint32_t s) { return s == 1; });
+    }
+};
+
+// Workers arrive and block, the controller waits until all of them are parked and then
+// releases them with a single notify; the gate is ready for the next round right after.
+// The gate may be destroyed once open() has returned: the destructor waits for released
+// workers that are still on their way out of arriveAndWait.
+class StartGate
+{
+    std::atomic<std::uint32_t> generation { 0 };
+    std::atomic<std::uint32_t> arrived { 0 };
+    std::uint32_t parties;
+    detail::CallsInside inside;
+
+public:
+    explicit StartGate(std::size_t parties) : parties { static_cast<std::uint32_t>(parties) } {}
+
+    StartGate(const StartGate&) = delete;
+    StartGate& operator=(const StartGate&) = delete;
+
+    ~StartGate() { inside.drain(); }
+
+    void arriveAndWait() noexcept
+    {
+        detail::CallsInside::Scope scope { inside };
+        auto current = generation.load(std::memory_order_acquire);
+        if (arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == parties)
+        {
+            arrived.notify_all();
+        }
+        detail::spinThenPark(generation, [current](std::uint32_t g) { return g != current; });
+    }
+
+    void waitUntilReady() const noexcept
+    {
+        detail::spinThenPark(arrived, [this](std::uint32_t a) { return a >= parties; });
+    }
+
+    void open() noexcept
+    {
+        detail::CallsInside::Scope scope { inside };
+        arrived.store(0, std::memory_order_relaxed);
+        generation.fetch_add(1, std::memory_order_release);
+        generation.notify_all();
+    }
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <thread>
+
+#include "CacheLine.h"
+
+/*
+ * Striped counter: increments are sharded over padded slots, reads add the slots up
+ */
+
+enum class ReadMode { Exact, Approximate };
+
+class StripedCounter
+{
+    struct alignas(cacheLineSize) Slot
+    {
+        std::atomic<long long> value { 0 };
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    std::size_t mask;
+
+    using Ticks = std::chrono::steady_clock::rep;
+    static constexpr Ticks never = std::numeric_limits<Ticks>::min();
+
+    // cached is published before cachedAt (release), so a reader that sees a time also sees
+    // a sum taken no earlier than that
+    std::chrono::nanoseconds staleness;
+    mutable std::atomic<long long> cached { 0 };
+    mutable std::atomic<Ticks> cachedAt { never };
+
+    // threads are numbered in order of first use and numbers are not reused, so the first
+    // numSlots threads get a slot each but with threads coming and going live threads can
+    // share one; that only costs contention, never correctness
+    static std::size_t threadId() noexcept
+    {
+        static std::atomic<std::size_t> nextId { 0 };
+        thread_local const std::size_t id = nextId.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+
+public:
+    explicit StripedCounter(std::size_t numSlots = 2 * std::thread::hardware_concurrency(),
+                            std::chrono::nanoseconds staleness = std::chrono::milliseconds(1))
+        : slots { std::make_unique<Slot[]>(std::bit_ceil(std::max<std::size_t>(numSlots, 1))) },
+          mask { std::bit_ceil(std::max<std::size_t>(numSlots, 1)) - 1 },
+          staleness { staleness }
+    {
+    }
+
+    StripedCounter(const StripedCounter&) = delete;
+    StripedCounter& operator=(const StripedCounter&) = delete;
+
+    std::size_t slotCount() const noexcept { return mask + 1; }
+
+    void increment(long long delta = 1) noexcept
+    {
+        slots[threadId() & mask].value.fetch_add(delta, std::memory_order_relaxed);
+    }
+
+    // Exact sums every slot; Approximate returns the last sum unless it is older than the staleness bound
+    long long load(ReadMode mode = ReadMode::Exact) const noexcept
+    {
+        if (mode == ReadMode::Approximate)
+        {
+            auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+            auto at = cachedAt.load(std::memory_order_acquire);
+            if (at != never && std::chrono::steady_clock::duration { now - at } < staleness)
+            {
+                return cached.load(std::memory_order_relaxed);
+            }
+            auto sum = aggregate();
+            cached.store(sum, std::memory_order_relaxed);
+            cachedAt.store(now, std::memory_order_release);
+            return sum;
+        }
+        return aggregate();
+    }
+
+    int getCount() const noexcept
+    {
+        return static_cast<int>(load(ReadMode::Exact));
+    }
+
+private:
+    long long aggregate() const noexcept
+    {
+        long long sum = 0;
+        for (std::size_t i = 0; i <= mask; ++i)
+        {
+            sum += slots[i].value.load(std::memory_order_relaxed);
+        }
+        return sum;
+    }
+};
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "CacheLine.h"
+
+/*
+ * Synchronized<T, Policy>: a value that can only be reached while properly synchronized
+ */
+
+// every access takes the same mutex
+struct ExclusivePolicy
+{
+    using Mutex = std::mutex;
+    using ReadLock = std::unique_lock<std::mutex>;
+};
+
+// readers share a reader-writer lock, writers are exclusive
+struct SharedPolicy
+{
+    using Mutex = std::shared_mutex;
+    using ReadLock = std::shared_lock<std::shared_mutex>;
+};
+
+// readers take optimistic copies and retry if a writer interfered, so they never write shared memory
+struct SeqLockPolicy {};
+
+template <typename T, typename Policy = ExclusivePolicy>
+class Synchronized
+{
+    mutable typename Policy::Mutex mutex;
+    T value;
+
+public:
+    template <typename... Ts>
+    explicit Synchronized(Ts&&... params) : value(std::forward<Ts>(params)...) {}
+
+    Synchronized(const Synchronized&) = delete;
+    Synchronized& operator=(const Synchronized&) = delete;
+
+    // f(T&) runs with exclusive access
+    template <typename F>
+    decltype(auto) withLock(F&& f)
+    {
+        std::lock_guard<typename Policy::Mutex> lock { mutex };
+        return std::invoke(std::forward<F>(f), value);
+    }
+
+    template <typename F>
+    decltype(auto) write(F&& f)
+    {
+        return withLock(std::forward<F>(f));
+    }
+
+    // f(const T&) runs with shared access if the policy allows it
+    template <typename F>
+    decltype(auto) read(F&& f) const
+    {
+        typename Policy::ReadLock lock { mutex };
+        return std::invoke(std::forward<F>(f), std::as_const(value));
+    }
+
+    T load() const
+    {
+        return read([](const T& v) { return v; });
+    }
+};
+
+template <typename T>
+class Synchronized<T, SeqLockPolicy>
+{
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLockPolicy needs a trivially copyable payload");
+
+    using Word = std::uint64_t;
+    static constexpr std::size_t numWords = (sizeof(T) + sizeof(Word) - 1) / sizeof(Word);
+
+    // the payload lives in atomic words, so a reader racing with a writer sees
+    // a torn copy (and retries) instead of undefined behavior
+    alignas(cacheLineSize) std::atomic<std::uint64_t> sequence { 0 };
+    std::array<std::atomic<Word>, numWords> words;
+    std::mutex writeMutex;
+
+public:
+    template <typename... Ts>
+    explicit Synchronized(Ts&&... params)
+    {
+        store(T(std::forward<Ts>(params)...));
+    }
+
+    Synchronized(const Synchronized&) = delete;
+    Synchronized& operator=(const Synchronized&) = delete;
+
+    // f(T&) modifies a private copy which is then published, writers are serialized
+    template <typename F>
+    auto withLock(F&& f)
+    {
+        std::lock_guard<std::mutex> lock { writeMutex };
+        auto copy = unpack();
+
+        if constexpr (std::is_void_v<std::invoke_result_t<F, T&>>)
+        {
+            std::invoke(std::forward<F>(f), copy);
+            publish(copy);
+        }
+        else
+        {
+            auto result = std::invoke(std::forward<F>(f), copy);
+            publish(copy);
+            return result;
+        }
+    }
+
+    template <typename F>
+    auto write(F&& f)
+    {
+        return withLock(std::forward<F>(f));
+    }
+
+    template <typename F>
+    auto read(F&& f) const
+    {
+        auto copy = load();
+        return std::invoke(std::forward<F>(f), std::as_const(copy));
+    }
+
+    T load() const
+    {
+        while (true)
+        {
+            auto before = sequence.load(std::memory_order_acquire);
+            if (before & 1)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            auto copy = unpack();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) == before)
+            {
+                return copy;
+            }
+        }
+    }
+
+private:
+    void store(const T& v)
+    {
+        std::lock_guard<std::mutex> lock { writeMutex };
+        publish(v);
+    }
+
+    // callers hold writeMutex
+    void publish(const T& v)
+    {
+        std::array<Word, numWords> raw {};
+        std::memcpy(raw.data(), &v, sizeof(T));
+
+        auto s = sequence.load(std::memory_order_relaxed);
+        sequence.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (std::size_t i = 0; i < numWords; ++i)
+        {
+            words[i].store(raw[i], std::memory_order_relaxed);
+        }
+        sequence.store(s + 2, std::memory_order_release);
+    }
+
+    T unpack() const
+    {
+        std::array<Word, numWords> raw;
+        for (std::size_t i = 0; i < numWords; ++i)
+        {
+            raw[i] = words[i].load(std::memory_order_relaxed);
+        }
+        std::array<unsigned char, sizeof(T)> bytes;
+        std::memcpy(bytes.data(), raw.data(), sizeof(T));
+        return std::bit_cast<T>(bytes);
+    }
+};
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <optional>
+#include <semaphore>
+#include <type_traits>
+#include <utility>
+
+#include "ThreadPool.h"
+
+/*
+ * Lazy coroutine Task<T> with symmetric transfer
+ */
+
+template <typename T = void>
+class Task;
+
+namespace detail
+{
+    struct TaskPromiseBase
+    {
+        std::coroutine_handle<> continuation = std::noop_coroutine();
+        std::exception_ptr error;
+
+        // the awaiting coroutine is resumed by tail call, so long chains do not grow the stack
+        struct FinalAwaiter
+        {
+            bool await_ready() const noexcept { return false; }
+
+            template <typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+            {
+                return handle.promise().continuation;
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void unhandled_exception() noexcept { error = std::current_exception(); }
+    };
+
+    template <typename T>
+    struct TaskPromise : TaskPromiseBase
+    {
+        std::optional<T> value;
+
+        Task<T> get_return_object() noexcept;
+
+        template <typename U = T>
+        void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+
+        T result()
+        {
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+            return std::move(*value);
+        }
+    };
+
+    template <>
+    struct TaskPromise<void> : TaskPromiseBase
+    {
+        Task<void> get_return_object() noexcept;
+
+        void return_void() const noexcept {}
+
+        void result()
+        {
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+    };
+}
+
+template <typename T>
+class Task
+{
+public:
+    using promise_type = detail::TaskPromise<T>;
+
+private:
+    std::coroutine_handle<promise_type> handle;
+
+    struct Awaiter
+    {
+        std::coroutine_handle<promise_type> handle;
+
+        bool await_ready() const noexcept { return !handle || handle.done(); }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            handle.promise().continuation = awaiting;
+            return handle;
+        }
+
+        // an empty (default or moved-from) task is ready at once and throws here
+        T await_resume()
+        {
+            if (!handle)
+            {
+                throw std::future_error(std::future_errc::no_state);
+            }
+            return handle.promise().result();
+        }
+    };
+
+    // resumes the awaiting coroutine once the task has finished, without fetching the result
+    struct ReadyAwaiter : Awaiter
+    {
+        void await_resume() const noexcept {}
+    };
+
+    template <typename U>
+    friend U sync_wait(Task<U> task);
+
+public:
+    Task() noexcept = default;
+    explicit Task(std::coroutine_handle<promise_type> h) noexcept : handle { h } {}
+
+    Task(Task&& other) noexcept : handle { std::exchange(other.handle, {}) } {}
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle)
+            {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, {});
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task()
+    {
+        if (handle)
+        {
+            handle.destroy();
+        }
+    }
+
+    bool isReady() const noexcept { return !handle || handle.done(); }
+
+    Awaiter operator co_await() const& noexcept { return Awaiter { handle }; }
+    Awaiter operator co_await() const&& noexcept { return Awaiter { handle }; }
+
+private:
+    ReadyAwaiter whenReady() const noexcept { return ReadyAwaiter { { handle } }; }
+};
+
+namespace detail
+{
+    template <typename T>
+    Task<T> TaskPromise<T>::get_return_object() noexcept
+    {
+        return Task<T> { std::coroutine_handle<TaskPromise<T>>::from_promise(*this) };
+    }
+
+    inline Task<void> TaskPromise<void>::get_return_object() noexcept
+    {
+        return Task<void> { std::coroutine_handle<TaskPromise<void>>::from_promise(*this) };
+    }
+
+    // driver coroutine for sync_wait, signals the waiting thread from its final suspend point
+    struct SyncWaitTask
+    {
+        struct promise_type
+        {
+            std::binary_semaphore* done = nullptr;
+
+            SyncWaitTask get_return_object() noexcept
+            {
+                return SyncWaitTask { std::coroutine_handle<promise_type>::from_promise(*this) };
+            }
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+
+            auto final_suspend() const noexcept
+            {
+                struct Notifier
+                {
+                    bool await_ready() const noexcept { return false; }
+                    void await_suspend(std::coroutine_handle<promise_type> h) const noexcept
+                    {
+                        h.promise().done->release();
+                    }
+                    void await_resume() const noexcept {}
+                };
+                return Notifier {};
+            }
+
+            void return_void() const noexcept {}
+            void unhandled_exception() const noexcept { std::terminate(); }
+        };
+
+        std::coroutine_handle<promise_type> handle;
+
+        explicit SyncWaitTask(std::coroutine_handle<promise_type> h) noexcept : handle { h } {}
+        SyncWaitTask(SyncWaitTask&& other) noexcept : handle { std::exchange(other.handle, {}) } {}
+        SyncWaitTask(const SyncWaitTask&) = delete;
+        ~SyncWaitTask()
+        {
+            if (handle)
+            {
+                handle.destroy();
+            }
+        }
+    };
+
+    template <typename Awaitable>
+    SyncWaitTask makeSyncWaitTask(Awaitable awaitable)
+    {
+        co_await awaitable;
+    }
+}
+
+// blocks the calling thread until the task has finished, wherever it ends up running
+template <typename T>
+T sync_wait(Task<T> task)
+{
+    if (!task.handle)
+    {
+        throw std::future_error(std::future_errc::no_state);
+    }
+    std::binary_semaphore done { 0 };
+    auto driver = detail::makeSyncWaitTask(task.whenReady());
+    driver.handle.promise().done = &done;
+    driver.handle.resume();
+    done.acquire();
+
+    return task.handle.promise().result();
+}
+
+// co_await schedule_on(pool) continues the coroutine on one of the pool's workers
+struct ScheduleOnAwaiter
+{
+    ThreadPool& pool;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) const
+    {
+        pool.post([handle]() { handle.resume(); });
+    }
+    void await_resume() const noexcept {}
+};
+
+inline ScheduleOnAwaiter schedule_on(ThreadPool& pool) noexcept
+{
+    return ScheduleOnAwaiter { pool };
+}
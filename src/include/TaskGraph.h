@@ -0,0 +1,243 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ThreadPool.h"
+
+/*
+ * TaskGraph: a DAG of callables scheduled on a ThreadPool
+ */
+
+// Nodes become ready when their last predecessor finishes, nobody blocks on a future.
+// Among the successors a finishing node releases, the one with the longest remaining
+// critical path continues on the same thread and the rest are posted to the pool, least
+// urgent first, so the owner (which pops its deque LIFO) takes them most urgent first.
+// Everything a run needs is laid out on the first run, later runs reuse it and allocate
+// nothing as long as the pool's queues are warm.
+class TaskGraph
+{
+public:
+    using NodeId = std::size_t;
+
+private:
+    struct Node
+    {
+        std::function<void()> work;
+        std::uint64_t cost;
+        std::vector<NodeId> successors;
+        std::size_t numPredecessors = 0;
+        // cost of the longest path from this node to the end of the graph, itself included
+        std::uint64_t priority = 0;
+        std::atomic<std::size_t> pendingPredecessors { 0 };
+    };
+
+    std::vector<std::unique_ptr<Node>> nodes;
+    std::vector<NodeId> roots;
+    bool prepared = false;
+
+    ThreadPool* pool = nullptr;
+    std::atomic<std::size_t> remaining { 0 };
+    // set by the thread that finished the last node once it no longer touches the graph
+    std::atomic<bool> finished { false };
+    std::atomic<bool> failed { false };
+    std::exception_ptr error;
+
+public:
+    TaskGraph() = default;
+    TaskGraph(const TaskGraph&) = delete;
+    TaskGraph& operator=(const TaskGraph&) = delete;
+
+    // cost is a relative estimate of the run time, only used to rank paths
+    template <typename F>
+    NodeId add(F&& f, std::uint64_t cost = 1)
+    {
+        auto node = std::make_unique<Node>();
+        node->work = std::forward<F>(f);
+        node->cost = cost;
+        nodes.push_back(std::move(node));
+        prepared = false;
+        return nodes.size() - 1;
+    }
+
+    // before finishes (and its writes are visible) before after starts
+    void precede(NodeId before, NodeId after)
+    {
+        nodes.at(before)->successors.push_back(after);
+        ++nodes.at(after)->numPredecessors;
+        prepared = false;
+    }
+
+    std::size_t size() const noexcept { return nodes.size(); }
+
+    std::uint64_t criticalPath(NodeId id)
+    {
+        prepare();
+        return nodes.at(id)->priority;
+    }
+
+    // runs every node once and returns when all are done; the calling thread takes part.
+    // After the first exception the remaining nodes are skipped, the exception is rethrown here.
+    void run(ThreadPool& onPool)
+    {
+        prepare();
+        if (nodes.empty())
+        {
+            return;
+        }
+
+        pool = &onPool;
+        for (auto& node : nodes)
+        {
+            node->pendingPredecessors.store(node->numPredecessors, std::memory_order_relaxed);
+        }
+        failed.store(false, std::memory_order_relaxed);
+        finished.store(false, std::memory_order_relaxed);
+        error = nullptr;
+        remaining.store(nodes.size(), std::memory_order_release);
+
+        for (std::size_t i = roots.size() - 1; i > 0; --i)
+        {
+            pool->post([this, id = roots[i]]() { execute(id); });
+        }
+        execute(roots.front());
+
+        auto left = remaining.load(std::memory_order_acquire);
+        while (left != 0)
+        {
+            remaining.wait(left, std::memory_order_acquire);
+            left = remaining.load(std::memory_order_acquire);
+        }
+        // the finisher may still be inside notify_all, the graph has to outlive that
+        while (!finished.load(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(std::exchange(error, nullptr));
+        }
+    }
+
+private:
+    // orders the graph once: critical path lengths, successors and roots by priority
+    void prepare()
+    {
+        if (prepared)
+        {
+            return;
+        }
+
+        std::vector<std::size_t> inDegree(nodes.size());
+        std::vector<NodeId> order;
+        order.reserve(nodes.size());
+        for (NodeId id = 0; id < nodes.size(); ++id)
+        {
+            inDegree[id] = nodes[id]->numPredecessors;
+            if (inDegree[id] == 0)
+            {
+                order.push_back(id);
+            }
+        }
+        for (std::size_t i = 0; i < order.size(); ++i)
+        {
+            for (auto next : nodes[order[i]]->successors)
+            {
+                if (--inDegree[next] == 0)
+                {
+                    order.push_back(next);
+                }
+            }
+        }
+        if (order.size() != nodes.size())
+        {
+            throw std::logic_error("TaskGraph has a cycle");
+        }
+
+        auto byPriority = [this](NodeId a, NodeId b) { return nodes[a]->priority > nodes[b]->priority; };
+        for (auto it = order.rbegin(); it != order.rend(); ++it)
+        {
+            auto& node = *nodes[*it];
+            std::uint64_t longestTail = 0;
+            for (auto next : node.successors)
+            {
+                longestTail = std::max(longestTail, nodes[next]->priority);
+            }
+            node.priority = node.cost + longestTail;
+            std::sort(node.successors.begin(), node.successors.end(), byPriority);
+        }
+
+        roots.clear();
+        for (NodeId id = 0; id < nodes.size(); ++id)
+        {
+            if (nodes[id]->numPredecessors == 0)
+            {
+                roots.push_back(id);
+            }
+        }
+        std::stable_sort(roots.begin(), roots.end(), byPriority);
+        prepared = true;
+    }
+
+    void execute(NodeId id) noexcept
+    {
+        while (true)
+        {
+            auto& node = *nodes[id];
+            if (!failed.load(std::memory_order_relaxed))
+            {
+                try
+                {
+                    node.work();
+                }
+                catch (...)
+                {
+                    if (!failed.exchange(true))
+                    {
+                        error = std::current_exception();
+                    }
+                }
+            }
+
+            // successors are sorted most urgent first; walking them backwards posts every released
+            // one but the most urgent in ascending priority and keeps that one for this thread
+            constexpr auto none = static_cast<NodeId>(-1);
+            NodeId next = none;
+            for (auto it = node.successors.rbegin(); it != node.successors.rend(); ++it)
+            {
+                auto successor = *it;
+                if (nodes[successor]->pendingPredecessors.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                {
+                    continue;
+                }
+                if (next != none)
+                {
+                    pool->post([this, id = next]() { execute(id); });
+                }
+                next = successor;
+            }
+
+            if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                remaining.notify_all();
+                finished.store(true, std::memory_order_release);
+                return;
+            }
+            if (next == none)
+            {
+                return;
+            }
+            id = next;
+        }
+    }
+};
@@ -0,0 +1,278 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <type_traits>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <time.h>
+#endif
+
+/*
+ * Opt-in task instrumentation: queue wait, run time, CPU time and blocking time histograms
+ */
+
+// Build everything with -DTASK_INSTRUMENTATION=1 to record; otherwise the probes are empty types,
+// instrumentTask hands the callable back untouched and nothing is measured.
+#ifndef TASK_INSTRUMENTATION
+#define TASK_INSTRUMENTATION 0
+#endif
+
+inline constexpr bool taskInstrumentation = TASK_INSTRUMENTATION != 0;
+
+// Nanosecond histogram with 8 linear sub-buckets per power of two (at most 12.5% relative
+// error), recording is a few relaxed atomic adds and never takes a lock.
+class LogLinearHistogram
+{
+    static constexpr unsigned subBits = 3;
+    static constexpr std::uint64_t subBuckets = 1 << subBits;
+
+public:
+    static constexpr std::size_t numBuckets = (64 - subBits + 1) * subBuckets;
+
+private:
+    std::array<std::atomic<std::uint64_t>, numBuckets> buckets {};
+    std::atomic<std::uint64_t> total { 0 };
+    std::atomic<std::uint64_t> sumNs { 0 };
+    std::atomic<std::uint64_t> maxNs { 0 };
+
+public:
+    static constexpr std::size_t bucketOf(std::uint64_t value) noexcept
+    {
+        if (value < subBuckets)
+        {
+            return static_cast<std::size_t>(value);
+        }
+        auto exponent = static_cast<unsigned>(std::bit_width(value)) - 1;
+        auto sub = (value >> (exponent - subBits)) & (subBuckets - 1);
+        return static_cast<std::size_t>((exponent - subBits + 1) * subBuckets + sub);
+    }
+
+    static constexpr std::uint64_t lowerBound(std::size_t bucket) noexcept
+    {
+        if (bucket < subBuckets)
+        {
+            return bucket;
+        }
+        auto exponent = bucket / subBuckets + subBits - 1;
+        auto sub = bucket % subBuckets;
+        return (std::uint64_t { 1 } << exponent) | (sub << (exponent - subBits));
+    }
+
+    void record(std::uint64_t ns) noexcept
+    {
+        buckets[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sumNs.fetch_add(ns, std::memory_order_relaxed);
+        auto seen = maxNs.load(std::memory_order_relaxed);
+        while (seen < ns && !maxNs.compare_exchange_weak(seen, ns, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void record(std::chrono::nanoseconds duration) noexcept
+    {
+        record(static_cast<std::uint64_t>(std::max<std::chrono::nanoseconds::rep>(duration.count(), 0)));
+    }
+
+    std::uint64_t count() const noexcept { return total.load(std::memory_order_relaxed); }
+    std::uint64_t sum() const noexcept { return sumNs.load(std::memory_order_relaxed); }
+    std::uint64_t max() const noexcept { return maxNs.load(std::memory_order_relaxed); }
+
+    // lower bound of the bucket holding the q-th quantile, q in [0, 1]
+    std::uint64_t percentile(double q) const noexcept
+    {
+        auto n = count();
+        if (n == 0)
+        {
+            return 0;
+        }
+        auto rank = static_cast<std::uint64_t>(q * static_cast<double>(n - 1));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < numBuckets; ++i)
+        {
+            seen += buckets[i].load(std::memory_order_relaxed);
+            if (seen > rank)
+            {
+                return lowerBound(i);
+            }
+        }
+        return max();
+    }
+
+    // not atomic as a whole, meant for between measurements
+    void reset() noexcept
+    {
+        for (auto& b : buckets)
+        {
+            b.store(0, std::memory_order_relaxed);
+        }
+        total.store(0, std::memory_order_relaxed);
+        sumNs.store(0, std::memory_order_relaxed);
+        maxNs.store(0, std::memory_order_relaxed);
+    }
+
+    void dumpText(std::ostream& os, const char* name) const
+    {
+        auto n = count();
+        os << name << ": count=" << n << " mean=" << (n ? sum() / n : 0) << "ns"
+           << " p50=" << percentile(0.5) << "ns p90=" << percentile(0.9) << "ns p99=" << percentile(0.99)
+           << "ns max=" << max() << "ns\n";
+    }
+
+    void dumpJson(std::ostream& os) const
+    {
+        os << "{\"count\":" << count() << ",\"sumNs\":" << sum() << ",\"maxNs\":" << max()
+           << ",\"p50Ns\":" << percentile(0.5) << ",\"p90Ns\":" << percentile(0.9)
+           << ",\"p99Ns\":" << percentile(0.99) << ",\"buckets\":[";
+        bool first = true;
+        for (std::size_t i = 0; i < numBuckets; ++i)
+        {
+            if (auto c = buckets[i].load(std::memory_order_relaxed))
+            {
+                os << (first ? "" : ",") << "[" << lowerBound(i) << "," << c << "]";
+                first = false;
+            }
+        }
+        os << "]}";
+    }
+};
+
+struct TaskStats
+{
+    LogLinearHistogram queueWait;   // enqueue until the task starts
+    LogLinearHistogram runTime;     // wall time spent running
+    LogLinearHistogram cpuTime;     // CPU time of the running thread
+    LogLinearHistogram blockedTime; // callers waiting in get() or join()
+
+    void reset() noexcept
+    {
+        queueWait.reset();
+        runTime.reset();
+        cpuTime.reset();
+        blockedTime.reset();
+    }
+
+    void dumpText(std::ostream& os) const
+    {
+        queueWait.dumpText(os, "queueWait");
+        runTime.dumpText(os, "runTime");
+        cpuTime.dumpText(os, "cpuTime");
+        blockedTime.dumpText(os, "blockedTime");
+    }
+
+    void dumpJson(std::ostream& os) const
+    {
+        os << "{\"queueWait\":";
+        queueWait.dumpJson(os);
+        os << ",\"runTime\":";
+        runTime.dumpJson(os);
+        os << ",\"cpuTime\":";
+        cpuTime.dumpJson(os);
+        os << ",\"blockedTime\":";
+        blockedTime.dumpJson(os);
+        os << "}";
+    }
+};
+
+inline TaskStats& taskStats()
+{
+    static TaskStats stats;
+    return stats;
+}
+
+// CPU time consumed by the calling thread, zero where the platform has no per-thread clock
+inline std::chrono::nanoseconds threadCpuTime() noexcept
+{
+#if defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec ts {};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return std::chrono::seconds { ts.tv_sec } + std::chrono::nanoseconds { ts.tv_nsec };
+#else
+    return std::chrono::nanoseconds { 0 };
+#endif
+}
+
+// created when a task is handed over, run() measures around the actual call
+template <bool Enabled>
+struct BasicTaskProbe
+{
+    std::chrono::steady_clock::time_point enqueued = std::chrono::steady_clock::now();
+
+    template <typename F, typename... Ts>
+    decltype(auto) run(F& f, Ts&&... params)
+    {
+        struct Measure
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            std::chrono::nanoseconds cpuStart = threadCpuTime();
+
+            ~Measure()
+            {
+                taskStats().runTime.record(std::chrono::steady_clock::now() - start);
+                taskStats().cpuTime.record(threadCpuTime() - cpuStart);
+            }
+        };
+
+        Measure measure;
+        taskStats().queueWait.record(measure.start - enqueued);
+        return std::invoke(f, std::forward<Ts>(params)...);
+    }
+};
+
+template <>
+struct BasicTaskProbe<false>
+{
+    template <typename F, typename... Ts>
+    decltype(auto) run(F& f, Ts&&... params)
+    {
+        return std::invoke(f, std::forward<Ts>(params)...);
+    }
+};
+
+using TaskProbe = BasicTaskProbe<taskInstrumentation>;
+
+// wraps f so that calling it records queue wait, run time and CPU time;
+// with instrumentation off this is f itself
+template <bool Enabled = taskInstrumentation, typename F>
+decltype(auto) instrumentTask(F&& f)
+{
+    if constexpr (Enabled)
+    {
+        return [probe = BasicTaskProbe<true> {}, f = std::forward<F>(f)]<typename... Ts>(Ts&&... params) mutable
+            -> decltype(auto) {
+            return probe.run(f, std::forward<Ts>(params)...);
+        };
+    }
+    else
+    {
+        return std::forward<F>(f);
+    }
+}
+
+// runs wait (a get() or join()) and records how long the caller was blocked in it
+template <bool Enabled = taskInstrumentation, typename F>
+decltype(auto) timeBlocking(F&& wait)
+{
+    if constexpr (Enabled)
+    {
+        struct Measure
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            ~Measure() { taskStats().blockedTime.record(std::chrono::steady_clock::now() - start); }
+        } measure;
+        return std::invoke(std::forward<F>(wait));
+    }
+    else
+    {
+        return std::invoke(std::forward<F>(wait));
+    }
+}
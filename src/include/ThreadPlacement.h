@@ -0,0 +1,239 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/*
+ * CPU topology, affinity and thread names
+ */
+
+struct CpuInfo
+{
+    unsigned id;
+    unsigned core;    // physical core within the package, hyperthreads share it
+    unsigned package; // socket
+};
+
+// Compact fills the hyperthreads of one core and the cores of one package before moving on,
+// workers share caches; Spread takes one hyperthread per core, alternating packages, before
+// it doubles up, workers get a core (and its L1/L2) each. None leaves it to the scheduler.
+enum class Placement { None, Compact, Spread };
+
+namespace detail
+{
+    // "0-3,6,8-9" as used by /sys/devices/system/cpu/online
+    inline std::vector<unsigned> parseCpuList(const std::string& list)
+    {
+        std::vector<unsigned> cpus;
+        std::istringstream in { list };
+        std::string range;
+        while (std::getline(in, range, ','))
+        {
+            if (range.empty() || range == "\n")
+            {
+                continue;
+            }
+            auto dash = range.find('-');
+            auto first = static_cast<unsigned>(std::stoul(range.substr(0, dash)));
+            auto last = dash == std::string::npos ? first : static_cast<unsigned>(std::stoul(range.substr(dash + 1)));
+            for (auto cpu = first; cpu <= last; ++cpu)
+            {
+                cpus.push_back(cpu);
+            }
+        }
+        return cpus;
+    }
+
+    inline bool readNumber(const std::string& path, unsigned& value)
+    {
+        std::ifstream in { path };
+        return static_cast<bool>(in >> value);
+    }
+}
+
+// the online CPUs as /sys/devices/system/cpu reports them; where that is not available every
+// hardware thread counts as its own core
+inline std::vector<CpuInfo> cpuTopology()
+{
+    const std::string root = "/sys/devices/system/cpu/";
+
+    std::vector<unsigned> ids;
+    std::ifstream online { root + "online" };
+    if (std::string list; std::getline(online, list))
+    {
+        ids = detail::parseCpuList(list);
+    }
+    if (ids.empty())
+    {
+        for (unsigned i = 0; i < std::max(1u, std::thread::hardware_concurrency()); ++i)
+        {
+            ids.push_back(i);
+        }
+    }
+
+    std::vector<CpuInfo> cpus;
+    for (auto id : ids)
+    {
+        CpuInfo cpu { id, id, 0 };
+        auto topology = root + "cpu" + std::to_string(id) + "/topology/";
+        detail::readNumber(topology + "core_id", cpu.core);
+        detail::readNumber(topology + "physical_package_id", cpu.package);
+        cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+// the CPU for each of numThreads threads, wrapping around when there are more threads than CPUs;
+// empty for Placement::None
+inline std::vector<unsigned> placeThreads(std::vector<CpuInfo> cpus, std::size_t numThreads, Placement placement)
+{
+    std::vector<unsigned> result;
+    if (placement == Placement::None || cpus.empty())
+    {
+        return result;
+    }
+
+    auto byLocation = [](const CpuInfo& a, const CpuInfo& b) {
+        return std::tie(a.package, a.core, a.id) < std::tie(b.package, b.core, b.id);
+    };
+    std::sort(cpus.begin(), cpus.end(), byLocation);
+
+    std::vector<unsigned> order;
+    if (placement == Placement::Compact)
+    {
+        for (auto& cpu : cpus)
+        {
+            order.push_back(cpu.id);
+        }
+    }
+    else
+    {
+        // rank of each CPU among the hyperthreads of its core and of its core within the package
+        std::vector<std::tuple<unsigned, unsigned, unsigned, unsigned>> ranked; // thread, core rank, package, id
+        unsigned coreRank = 0;
+        unsigned threadRank = 0;
+        for (std::size_t i = 0; i < cpus.size(); ++i)
+        {
+            if (i > 0 && cpus[i].package != cpus[i - 1].package)
+            {
+                coreRank = 0;
+                threadRank = 0;
+            }
+            else if (i > 0 && cpus[i].core != cpus[i - 1].core)
+            {
+                ++coreRank;
+                threadRank = 0;
+            }
+            else if (i > 0)
+            {
+                ++threadRank;
+            }
+            ranked.emplace_back(threadRank, coreRank, cpus[i].package, cpus[i].id);
+        }
+        std::sort(ranked.begin(), ranked.end());
+        for (auto& entry : ranked)
+        {
+            order.push_back(std::get<3>(entry));
+        }
+    }
+
+    for (std::size_t i = 0; i < numThreads; ++i)
+    {
+        result.push_back(order[i % order.size()]);
+    }
+    return result;
+}
+
+// false if the platform has no affinity control or refused the set
+inline bool pinCurrentThread(const std::vector<unsigned>& cpus)
+{
+#ifdef __linux__
+    if (cpus.empty())
+    {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto cpu : cpus)
+    {
+        if (cpu >= CPU_SETSIZE)
+        {
+            return false;
+        }
+        CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+// the CPUs the calling thread may run on, empty where that is unknown
+inline std::vector<unsigned> currentThreadAffinity()
+{
+    std::vector<unsigned> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0)
+    {
+        for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &set))
+            {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    return cpus;
+}
+
+// cpuTopology restricted to the CPUs the calling thread may run on (taskset and cgroups shrink it)
+inline std::vector<CpuInfo> usableCpus()
+{
+    auto cpus = cpuTopology();
+    auto allowed = currentThreadAffinity();
+    if (!allowed.empty())
+    {
+        std::erase_if(cpus, [&allowed](const CpuInfo& cpu) {
+            return std::find(allowed.begin(), allowed.end(), cpu.id) == allowed.end();
+        });
+    }
+    return cpus;
+}
+
+// Linux keeps at most 15 characters, longer names are cut
+inline bool setCurrentThreadName(const std::string& name)
+{
+#ifdef __linux__
+    return pthread_setname_np(pthread_self(), name.substr(0, 15).c_str()) == 0;
+#else
+    (void)name;
+    return false;
+#endif
+}
+
+inline std::string currentThreadName()
+{
+#ifdef __linux__
+    char name[16] {};
+    if (pthread_getname_np(pthread_self(), name, sizeof(name)) == 0)
+    {
+        return name;
+    }
+#endif
+    return {};
+}
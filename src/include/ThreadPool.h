@@ -0,0 +1,354 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "TaskStats.h"
+
+/*
+ * Work-stealing thread pool
+ */
+
+namespace detail
+{
+    // move-only type-erased callable, small callables are stored inline
+    class Job
+    {
+        static constexpr std::size_t bufferSize = 48;
+
+        struct VTable
+        {
+            void (*invoke)(void*);
+            void (*move)(void* dst, void* src) noexcept;
+            void (*destroy)(void*) noexcept;
+        };
+
+        template <typename F>
+        static constexpr bool storedInline = sizeof(F) <= bufferSize
+                                          && alignof(F) <= alignof(std::max_align_t)
+                                          && std::is_nothrow_move_constructible_v<F>;
+
+        template <typename F>
+        static constexpr VTable inlineVTable
+        {
+            [](void* p) { (*static_cast<F*>(p))(); },
+            [](void* dst, void* src) noexcept
+            {
+                ::new (dst) F { std::move(*static_cast<F*>(src)) };
+                static_cast<F*>(src)->~F();
+            },
+            [](void* p) noexcept { static_cast<F*>(p)->~F(); }
+        };
+
+        template <typename F>
+        static constexpr VTable heapVTable
+        {
+            [](void* p) { (**static_cast<F**>(p))(); },
+            [](void* dst, void* src) noexcept
+            {
+                ::new (dst) F* { *static_cast<F**>(src) };
+            },
+            [](void* p) noexcept { delete *static_cast<F**>(p); }
+        };
+
+        alignas(std::max_align_t) unsigned char buffer[bufferSize];
+        const VTable* vtable = nullptr;
+
+    public:
+        Job() noexcept = default;
+
+        template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Job>>>
+        Job(F&& f)
+        {
+            using Fn = std::decay_t<F>;
+            if constexpr (storedInline<Fn>)
+            {
+                ::new (static_cast<void*>(buffer)) Fn { std::forward<F>(f) };
+                vtable = &inlineVTable<Fn>;
+            }
+            else
+            {
+                ::new (static_cast<void*>(buffer)) Fn* { new Fn { std::forward<F>(f) } };
+                vtable = &heapVTable<Fn>;
+            }
+        }
+
+        Job(Job&& other) noexcept : vtable { other.vtable }
+        {
+            if (vtable)
+            {
+                vtable->move(buffer, other.buffer);
+                other.vtable = nullptr;
+            }
+        }
+
+        Job& operator=(Job&& other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                vtable = other.vtable;
+                if (vtable)
+                {
+                    vtable->move(buffer, other.buffer);
+                    other.vtable = nullptr;
+                }
+            }
+            return *this;
+        }
+
+        Job(const Job&) = delete;
+        Job& operator=(const Job&) = delete;
+
+        ~Job() { reset(); }
+
+        void operator()() { vtable->invoke(buffer); }
+
+        explicit operator bool() const noexcept { return vtable != nullptr; }
+
+    private:
+        void reset() noexcept
+        {
+            if (vtable)
+            {
+                vtable->destroy(buffer);
+                vtable = nullptr;
+            }
+        }
+    };
+
+    // growable ring of jobs, unlike std::deque it stops allocating once it has grown large enough
+    class JobRing
+    {
+        std::vector<Job> buffer;
+        std::size_t head = 0;
+        std::size_t count = 0;
+
+    public:
+        bool empty() const noexcept { return count == 0; }
+        std::size_t size() const noexcept { return count; }
+
+        void push_back(Job&& job)
+        {
+            if (count == buffer.size())
+            {
+                grow();
+            }
+            buffer[(head + count) & (buffer.size() - 1)] = std::move(job);
+            ++count;
+        }
+
+        Job pop_back() noexcept
+        {
+            --count;
+            return std::move(buffer[(head + count) & (buffer.size() - 1)]);
+        }
+
+        Job pop_front() noexcept
+        {
+            auto job = std::move(buffer[head]);
+            head = (head + 1) & (buffer.size() - 1);
+            --count;
+            return job;
+        }
+
+    private:
+        void grow()
+        {
+            std::vector<Job> bigger(std::max<std::size_t>(16, buffer.size() * 2));
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                bigger[i] = std::move(buffer[(head + i) & (buffer.size() - 1)]);
+            }
+            buffer.swap(bigger);
+            head = 0;
+        }
+    };
+}
+
+class ThreadPool
+{
+    // each worker owns a queue: it pushes and pops at the back, thieves take from the front
+    struct alignas(64) Worker
+    {
+        std::mutex mutex;
+        detail::JobRing jobs;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::atomic<std::size_t> pending { 0 };
+    std::atomic<std::size_t> sleeping { 0 };
+    std::atomic<std::size_t> nextWorker { 0 };
+    std::atomic<bool> stopping { false };
+
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+
+    static inline thread_local ThreadPool* currentPool = nullptr;
+    static inline thread_local std::size_t currentIndex = 0;
+
+public:
+    explicit ThreadPool(std::size_t numThreads = std::thread::hardware_concurrency())
+    {
+        numThreads = std::max<std::size_t>(numThreads, 1);
+        workers.reserve(numThreads);
+        for (std::size_t i = 0; i < numThreads; ++i)
+        {
+            workers.push_back(std::make_unique<Worker>());
+        }
+        threads.reserve(numThreads);
+        for (std::size_t i = 0; i < numThreads; ++i)
+        {
+            threads.emplace_back(&ThreadPool::run, this, i);
+        }
+    }
+
+    // outstanding jobs are drained before the workers are joined
+    ~ThreadPool()
+    {
+        stopping.store(true);
+        {
+            std::lock_guard<std::mutex> lock { sleepMutex };
+        }
+        wakeUp.notify_all();
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ThreadPool(ThreadPool&&) = delete;
+    ThreadPool& operator=(ThreadPool&&) = delete;
+
+    std::size_t size() const noexcept { return workers.size(); }
+
+    // true if the calling thread is one of this pool's workers
+    bool isWorkerThread() const noexcept { return currentPool == this; }
+
+    // fire-and-forget, an exception escaping the job terminates the program;
+    // if the job can not be queued (bad_alloc), post throws and the pool is unchanged
+    template <typename F>
+    void post(F&& f)
+    {
+        detail::Job job { std::forward<F>(f) };
+
+        // counted before it becomes visible, so a worker taking it never sees pending drop below zero
+        pending.fetch_add(1);
+
+        auto index = isWorkerThread() ? currentIndex
+                                      : nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size();
+        {
+            std::lock_guard<std::mutex> lock { workers[index]->mutex };
+            try
+            {
+                workers[index]->jobs.push_back(std::move(job));
+            }
+            catch (...)
+            {
+                pending.fetch_sub(1);
+                throw;
+            }
+        }
+
+        if (sleeping.load() > 0)
+        {
+            {
+                std::lock_guard<std::mutex> lock { sleepMutex };
+            }
+            wakeUp.notify_one();
+        }
+    }
+
+    template <typename F, typename... Ts>
+    auto submit(F&& f, Ts&&... params)
+    {
+        using R = std::invoke_result_t<std::decay_t<F>, std::decay_t<Ts>...>;
+
+        std::packaged_task<R()> task {
+            instrumentTask([f = std::forward<F>(f), ... params = std::forward<Ts>(params)]() mutable
+            {
+                return std::invoke(std::move(f), std::move(params)...);
+            })
+        };
+        auto future = task.get_future();
+        post(std::move(task));
+        return future;
+    }
+
+private:
+    bool tryPop(std::size_t index, detail::Job& job)
+    {
+        auto& worker = *workers[index];
+        std::lock_guard<std::mutex> lock { worker.mutex };
+        if (worker.jobs.empty())
+        {
+            return false;
+        }
+        job = worker.jobs.pop_back();
+        return true;
+    }
+
+    bool trySteal(std::size_t index, detail::Job& job)
+    {
+        for (std::size_t i = 1; i < workers.size(); ++i)
+        {
+            auto& victim = *workers[(index + i) % workers.size()];
+            std::lock_guard<std::mutex> lock { victim.mutex };
+            if (!victim.jobs.empty())
+            {
+                job = victim.jobs.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run(std::size_t index)
+    {
+        currentPool = this;
+        currentIndex = index;
+
+        detail::Job job;
+        while (true)
+        {
+            if (tryPop(index, job) || trySteal(index, job))
+            {
+                pending.fetch_sub(1);
+                job();
+                job = detail::Job {};
+                continue;
+            }
+            if (stopping.load() && pending.load() == 0)
+            {
+                return;
+            }
+
+            std::unique_lock<std::mutex> lock { sleepMutex };
+            sleeping.fetch_add(1);
+            wakeUp.wait(lock, [this] { return pending.load() > 0 || stopping.load(); });
+            sleeping.fetch_sub(1);
+        }
+    }
+};
+
+// process-wide pool sized to the hardware, created on first use
+inline ThreadPool& defaultThreadPool()
+{
+    static ThreadPool pool;
+    return pool;
+}
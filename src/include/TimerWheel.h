@@ -0,0 +1,284 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ThreadPool.h"
+#include "Future.h"
+
+/*
+ * Hierarchical timer wheel driven by a single thread
+ */
+
+// Four levels of 64 slots: level 0 holds the next 64 ticks, each higher level covers
+// 64 times the span of the one below and is cascaded down as the lower level wraps.
+// Timers cost a slot entry, not a thread; callbacks run on the driver thread.
+class TimerWheel
+{
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr unsigned slotBits = 6;
+    static constexpr std::size_t slotsPerLevel = std::size_t { 1 } << slotBits;
+    static constexpr std::size_t slotMask = slotsPerLevel - 1;
+    static constexpr std::size_t numLevels = 4;
+
+    struct Entry
+    {
+        std::uint64_t deadline;
+        detail::Job callback;
+    };
+
+    using Slot = std::vector<Entry>;
+
+    Clock::duration tickDuration;
+    Clock::time_point start;
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::array<std::array<Slot, slotsPerLevel>, numLevels> levels;
+    std::uint64_t currentTick = 0;
+    std::uint64_t plannedWakeTick = 0;
+    std::size_t pendingCount = 0;
+    bool rescheduled = false;
+    bool stopping = false;
+
+    std::thread driver;
+
+public:
+    explicit TimerWheel(Clock::duration tick = std::chrono::milliseconds(1))
+        : tickDuration { tick }, start { Clock::now() }, driver { &TimerWheel::run, this }
+    {
+    }
+
+    // timers that have not fired yet are dropped, futures waiting on them see a broken promise;
+    // coroutines sleeping on the wheel are resumed here and their co_await throws the same
+    ~TimerWheel()
+    {
+        {
+            std::lock_guard<std::mutex> lock { mutex };
+            stopping = true;
+        }
+        changed.notify_one();
+        driver.join();
+
+        // a resumed sleeper may go back to sleep on the wheel, so drain until nothing is left
+        while (pendingCount != 0)
+        {
+            auto dropped = std::move(levels);
+            levels = {};
+            pendingCount = 0;
+        }
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    std::size_t pending()
+    {
+        std::lock_guard<std::mutex> lock { mutex };
+        return pendingCount;
+    }
+
+    // f runs on the driver thread once delay has passed, rounded up to whole ticks;
+    // its result, or the exception it throws, ends up in the returned future
+    template <typename F>
+    auto schedule(Clock::duration delay, F&& f)
+    {
+        using R = std::invoke_result_t<std::decay_t<F>&>;
+
+        Promise<R> promise;
+        auto future = promise.get_future();
+        enqueue(delay, [f = std::forward<F>(f), promise = std::move(promise)]() mutable noexcept {
+            detail::fulfil(promise, f);
+        });
+        return future;
+    }
+
+    Future<void> after(Clock::duration delay)
+    {
+        return schedule(delay, []() {});
+    }
+
+    // co_await timer.sleep(d) resumes the coroutine on the driver thread,
+    // follow it with schedule_on(pool) before doing real work
+    struct SleepAwaiter
+    {
+        TimerWheel& timer;
+        Clock::duration delay;
+        bool cancelled = false;
+
+        bool await_ready() const noexcept { return delay <= Clock::duration::zero(); }
+        void await_suspend(std::coroutine_handle<> handle)
+        {
+            timer.enqueue(delay, Wakeup { handle, &cancelled });
+        }
+        void await_resume() const
+        {
+            if (cancelled)
+            {
+                throw std::future_error(std::future_errc::broken_promise);
+            }
+        }
+    };
+
+    SleepAwaiter sleep(Clock::duration delay) noexcept
+    {
+        return SleepAwaiter { *this, delay };
+    }
+
+private:
+    // resumes the sleeper when it fires; dropped unfired, it resumes it as cancelled
+    struct Wakeup
+    {
+        std::coroutine_handle<> handle;
+        bool* cancelled;
+
+        Wakeup(std::coroutine_handle<> h, bool* c) noexcept : handle { h }, cancelled { c } {}
+        Wakeup(Wakeup&& other) noexcept
+            : handle { std::exchange(other.handle, nullptr) }, cancelled { other.cancelled }
+        {
+        }
+        Wakeup& operator=(Wakeup&&) = delete;
+
+        ~Wakeup()
+        {
+            if (handle)
+            {
+                *cancelled = true;
+                handle.resume();
+            }
+        }
+
+        void operator()() noexcept { std::exchange(handle, nullptr).resume(); }
+    };
+
+    // job runs on the driver thread and must not throw
+    void enqueue(Clock::duration delay, detail::Job job)
+    {
+        auto deadline = ticksUntil(Clock::now() + delay);
+        bool wake;
+        {
+            std::lock_guard<std::mutex> lock { mutex };
+            deadline = std::max(deadline, currentTick + 1);
+            place(Entry { deadline, std::move(job) });
+            ++pendingCount;
+            wake = deadline < plannedWakeTick;
+            rescheduled = rescheduled || wake;
+        }
+        if (wake)
+        {
+            changed.notify_one();
+        }
+    }
+
+    std::uint64_t ticksUntil(Clock::time_point when) const
+    {
+        if (when <= start)
+        {
+            return 0;
+        }
+        auto elapsed = when - start;
+        return static_cast<std::uint64_t>((elapsed + tickDuration - Clock::duration { 1 }) / tickDuration);
+    }
+
+    // callers hold the mutex
+    void place(Entry&& entry)
+    {
+        auto delta = entry.deadline > currentTick ? entry.deadline - currentTick : 0;
+        std::size_t level = 0;
+        while (level + 1 < numLevels && delta >= (std::uint64_t { 1 } << (slotBits * (level + 1))))
+        {
+            ++level;
+        }
+        auto slot = (std::max(entry.deadline, currentTick) >> (slotBits * level)) & slotMask;
+        levels[level][slot].push_back(std::move(entry));
+    }
+
+    // advances one tick, moves the due entries into expired
+    void advance(Slot& expired)
+    {
+        ++currentTick;
+        for (std::size_t level = numLevels - 1; level > 0; --level)
+        {
+            auto lowerBits = slotBits * level;
+            if ((currentTick & ((std::uint64_t { 1 } << lowerBits) - 1)) != 0)
+            {
+                continue;
+            }
+            auto cascading = std::move(levels[level][(currentTick >> lowerBits) & slotMask]);
+            levels[level][(currentTick >> lowerBits) & slotMask].clear();
+            for (auto& entry : cascading)
+            {
+                place(std::move(entry));
+            }
+        }
+
+        auto& due = levels[0][currentTick & slotMask];
+        for (auto& entry : due)
+        {
+            expired.push_back(std::move(entry));
+        }
+        due.clear();
+    }
+
+    // the next tick that has entries in level 0 or has to cascade a higher level
+    std::uint64_t nextWorkTick() const
+    {
+        for (std::uint64_t tick = currentTick + 1; ; ++tick)
+        {
+            if (!levels[0][tick & slotMask].empty() || (tick & slotMask) == 0)
+            {
+                return tick;
+            }
+        }
+    }
+
+    void run()
+    {
+        Slot expired;
+        std::unique_lock<std::mutex> lock { mutex };
+        while (true)
+        {
+            plannedWakeTick = pendingCount == 0 ? UINT64_MAX : nextWorkTick();
+            rescheduled = false;
+            auto woken = [this] { return stopping || rescheduled; };
+            if (plannedWakeTick == UINT64_MAX)
+            {
+                changed.wait(lock, woken);
+            }
+            else
+            {
+                changed.wait_until(lock, start + tickDuration * static_cast<Clock::rep>(plannedWakeTick), woken);
+            }
+            if (stopping)
+            {
+                return;
+            }
+
+            auto now = static_cast<std::uint64_t>((Clock::now() - start) / tickDuration);
+            while (currentTick < now)
+            {
+                advance(expired);
+            }
+            pendingCount -= expired.size();
+
+            lock.unlock();
+            for (auto& entry : expired)
+            {
+                entry.callback();
+            }
+            expired.clear();
+            lock.lock();
+        }
+    }
+};
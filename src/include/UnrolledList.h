@@ -0,0 +1,447 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "CacheLine.h"
+
+/*
+ * Unrolled linked list: a doubly linked list of small arrays
+ */
+
+// Every node holds up to Capacity elements in place, with Capacity picked so that a node
+// covers two cache lines; a scan touches one pair of lines per Capacity elements instead of
+// one node per element. A full node splits in half on insert, a node that drops below a
+// quarter full is merged with a neighbour when the two fit into one node.
+// Same interface as LinkedList: push/pop at both ends, insert/remove by position, iterators.
+template <typename T>
+class UnrolledList
+{
+    static constexpr std::size_t headerBytes = 2 * sizeof(void*) + sizeof(std::size_t);
+
+public:
+    static constexpr std::size_t Capacity =
+        std::max<std::size_t>(4, (2 * cacheLineSize - headerBytes) / sizeof(T));
+
+private:
+    struct alignas(cacheLineSize) Node
+    {
+        Node* next = nullptr;
+        Node* prev = nullptr;
+        std::size_t count = 0;
+        alignas(T) unsigned char storage[Capacity * sizeof(T)];
+
+        T* items() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+        const T* items() const noexcept { return std::launder(reinterpret_cast<const T*>(storage)); }
+
+        ~Node()
+        {
+            std::destroy_n(items(), count);
+        }
+
+        // shifts [pos, count) up by one and constructs value at pos; the node has room
+        void insertAt(std::size_t pos, T value)
+        {
+            if (pos == count)
+            {
+                ::new (items() + count) T(std::move(value));
+            }
+            else
+            {
+                ::new (items() + count) T(std::move(items()[count - 1]));
+                std::move_backward(items() + pos, items() + count - 1, items() + count);
+                items()[pos] = std::move(value);
+            }
+            ++count;
+        }
+
+        void eraseAt(std::size_t pos)
+        {
+            std::move(items() + pos + 1, items() + count, items() + pos);
+            std::destroy_at(items() + count - 1);
+            --count;
+        }
+
+        // moves [from, count) to the end of other
+        void moveTail(std::size_t from, Node& other)
+        {
+            std::uninitialized_move(items() + from, items() + count, other.items() + other.count);
+            other.count += count - from;
+            std::destroy(items() + from, items() + count);
+            count = from;
+        }
+    };
+
+    Node* head = nullptr;
+    Node* tail = nullptr;
+    std::size_t total = 0;
+    std::size_t nodes = 0;
+
+    template <bool Const>
+    class BasicIterator
+    {
+        using NodePtr = std::conditional_t<Const, const Node*, Node*>;
+        using ListPtr = std::conditional_t<Const, const UnrolledList*, UnrolledList*>;
+
+        ListPtr list = nullptr;
+        NodePtr node = nullptr;
+        std::size_t offset = 0;
+
+        friend class UnrolledList;
+
+        BasicIterator(ListPtr l, NodePtr n, std::size_t o) noexcept : list { l }, node { n }, offset { o } {}
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+        using reference = std::conditional_t<Const, const T&, T&>;
+
+        BasicIterator() noexcept = default;
+
+        // iterator converts to const_iterator
+        template <bool OtherConst>
+            requires(Const && !OtherConst)
+        BasicIterator(const BasicIterator<OtherConst>& other) noexcept
+            : list { other.list }, node { other.node }, offset { other.offset }
+        {
+        }
+
+        reference operator*() const noexcept { return node->items()[offset]; }
+        pointer operator->() const noexcept { return node->items() + offset; }
+
+        BasicIterator& operator++() noexcept
+        {
+            if (++offset == node->count)
+            {
+                node = node->next;
+                offset = 0;
+            }
+            return *this;
+        }
+
+        BasicIterator operator++(int) noexcept
+        {
+            auto temp = *this;
+            ++*this;
+            return temp;
+        }
+
+        BasicIterator& operator--() noexcept
+        {
+            if (node == nullptr)
+            {
+                node = list->tail;
+                offset = node->count - 1;
+            }
+            else if (offset == 0)
+            {
+                node = node->prev;
+                offset = node->count - 1;
+            }
+            else
+            {
+                --offset;
+            }
+            return *this;
+        }
+
+        BasicIterator operator--(int) noexcept
+        {
+            auto temp = *this;
+            --*this;
+            return temp;
+        }
+
+        explicit operator bool() const noexcept { return node != nullptr; }
+
+        bool operator==(const BasicIterator& other) const noexcept
+        {
+            return node == other.node && offset == other.offset;
+        }
+
+        template <bool>
+        friend class BasicIterator;
+    };
+
+public:
+    using value_type = T;
+    using iterator = BasicIterator<false>;
+    using const_iterator = BasicIterator<true>;
+
+    UnrolledList() = default;
+    UnrolledList(std::initializer_list<T> initList)
+    {
+        for (auto& value : initList)
+        {
+            push_back(value);
+        }
+    }
+    UnrolledList(const UnrolledList& other)
+    {
+        for (auto& value : other)
+        {
+            push_back(value);
+        }
+    }
+    UnrolledList(UnrolledList&& other) noexcept
+        : head { std::exchange(other.head, nullptr) }, tail { std::exchange(other.tail, nullptr) },
+          total { std::exchange(other.total, 0) }, nodes { std::exchange(other.nodes, 0) }
+    {
+    }
+    UnrolledList& operator=(const UnrolledList& other)
+    {
+        if (this != &other)
+        {
+            UnrolledList temp(other);
+            swap(temp);
+        }
+        return *this;
+    }
+    UnrolledList& operator=(UnrolledList&& other) noexcept
+    {
+        if (this != &other)
+        {
+            erase();
+            swap(other);
+        }
+        return *this;
+    }
+    ~UnrolledList()
+    {
+        erase();
+    }
+
+    void swap(UnrolledList& other) noexcept
+    {
+        std::swap(head, other.head);
+        std::swap(tail, other.tail);
+        std::swap(total, other.total);
+        std::swap(nodes, other.nodes);
+    }
+
+    iterator begin() noexcept { return iterator { this, head, 0 }; }
+    iterator end() noexcept { return iterator { this, nullptr, 0 }; }
+    const_iterator begin() const noexcept { return const_iterator { this, head, 0 }; }
+    const_iterator end() const noexcept { return const_iterator { this, nullptr, 0 }; }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    UnrolledList& push_back(const T& value)
+    {
+        if (tail == nullptr || tail->count == Capacity)
+        {
+            linkAfter(tail, nodeWith(value));
+        }
+        else
+        {
+            tail->insertAt(tail->count, value);
+        }
+        ++total;
+        return *this;
+    }
+    UnrolledList& push_front(const T& value)
+    {
+        if (head == nullptr || head->count == Capacity)
+        {
+            linkAfter(nullptr, nodeWith(value));
+        }
+        else
+        {
+            head->insertAt(0, value);
+        }
+        ++total;
+        return *this;
+    }
+    UnrolledList& pop_back()
+    {
+        if (tail == nullptr)
+        {
+            throw std::runtime_error { "pop from empty list" };
+        }
+        eraseIn(tail, tail->count - 1);
+        return *this;
+    }
+    UnrolledList& pop_front()
+    {
+        if (head == nullptr)
+        {
+            throw std::runtime_error("pop from empty list");
+        }
+        eraseIn(head, 0);
+        return *this;
+    }
+    UnrolledList& insert(const T& value, std::size_t pos)
+    {
+        if (pos == 0)
+        {
+            return push_front(value);
+        }
+        if (pos == total)
+        {
+            return push_back(value);
+        }
+        if (pos > total)
+        {
+            throw std::out_of_range("index out of range");
+        }
+
+        auto [node, offset] = locate(pos);
+        if (node->count == Capacity)
+        {
+            auto half = new Node;
+            linkAfter(node, half);
+            node->moveTail(Capacity / 2, *half);
+            if (offset > node->count)
+            {
+                offset -= node->count;
+                node = half;
+            }
+        }
+        node->insertAt(offset, value);
+        ++total;
+        return *this;
+    }
+    UnrolledList& remove(std::size_t pos)
+    {
+        if (pos == 0)
+        {
+            return pop_front();
+        }
+        if (pos >= total)
+        {
+            throw std::out_of_range("index out of range");
+        }
+
+        auto [node, offset] = locate(pos);
+        eraseIn(node, offset);
+        return *this;
+    }
+
+    // unchecked, walks the nodes from the nearer end
+    T& operator[](std::size_t pos) noexcept
+    {
+        auto [node, offset] = locate(pos);
+        return node->items()[offset];
+    }
+    const T& operator[](std::size_t pos) const noexcept
+    {
+        auto [node, offset] = locate(pos);
+        return node->items()[offset];
+    }
+
+    std::size_t size() const noexcept { return total; }
+    bool empty() const noexcept { return total == 0; }
+
+    // heap memory held by the nodes
+    std::size_t memoryBytes() const noexcept { return nodes * sizeof(Node); }
+
+    UnrolledList& erase() noexcept
+    {
+        while (head != nullptr)
+        {
+            delete std::exchange(head, head->next);
+        }
+        tail = nullptr;
+        total = 0;
+        nodes = 0;
+        return *this;
+    }
+
+private:
+    // a new node holding value; if copying value throws nothing is left behind, so the list
+    // never links a node without elements
+    static Node* nodeWith(const T& value)
+    {
+        auto node = std::make_unique<Node>();
+        node->insertAt(0, value);
+        return node.release();
+    }
+
+    // prev == nullptr links node in front
+    void linkAfter(Node* prev, Node* node) noexcept
+    {
+        auto next = prev ? prev->next : head;
+        node->prev = prev;
+        node->next = next;
+        (prev ? prev->next : head) = node;
+        (next ? next->prev : tail) = node;
+        ++nodes;
+    }
+
+    void unlink(Node* node) noexcept
+    {
+        (node->prev ? node->prev->next : head) = node->next;
+        (node->next ? node->next->prev : tail) = node->prev;
+        delete node;
+        --nodes;
+    }
+
+    std::pair<Node*, std::size_t> locate(std::size_t pos) const noexcept
+    {
+        if (pos < total / 2)
+        {
+            auto node = head;
+            while (pos >= node->count)
+            {
+                pos -= node->count;
+                node = node->next;
+            }
+            return { node, pos };
+        }
+        auto node = tail;
+        auto before = total - node->count;
+        while (pos < before)
+        {
+            node = node->prev;
+            before -= node->count;
+        }
+        return { node, pos - before };
+    }
+
+    void eraseIn(Node* node, std::size_t offset)
+    {
+        node->eraseAt(offset);
+        --total;
+        if (node->count == 0)
+        {
+            unlink(node);
+            return;
+        }
+        if (node->count >= Capacity / 4)
+        {
+            return;
+        }
+        if (node->next && node->count + node->next->count <= Capacity)
+        {
+            node->next->moveTail(0, *node);
+            unlink(node->next);
+        }
+        else if (node->prev && node->prev->count + node->count <= Capacity)
+        {
+            node->moveTail(0, *node->prev);
+            unlink(node);
+        }
+    }
+};
+
+template <typename T>
+inline bool operator==(const UnrolledList<T>& lhs, const UnrolledList<T>& rhs) noexcept
+{
+    return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <typename T>
+inline bool operator!=(const UnrolledList<T>& lhs, const UnrolledList<T>& rhs) noexcept
+{
+    return !(lhs == rhs);
+}
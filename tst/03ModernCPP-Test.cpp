@@ -6,6 +6,7 @@
 #include <stdexcept>
 #include <thread>
 #include <utility>
+#include <atomic>
 
 #include "03ModernCPP.h"
 
@@ -228,6 +229,126 @@ TEST(ModernCPPTestItem16, ThreadSafeClassWithMutex)
     EXPECT_EQ(counter.getCount(), iterations * 2);
 }
 
+TEST(ModernCPPTestItem16, ThreadSafeClassWithAdaptiveMutex)
+{
+    SafeCounter<InstrumentedAdaptiveMutex> counter;
+    int iterations { 10000 };
+
+    std::thread t1([&counter, iterations]() { threadFunc(counter, iterations); });
+    std::thread t2([&counter, iterations]() { threadFunc(counter, iterations); });
+
+    t1.join();
+    t2.join();
+
+    EXPECT_EQ(counter.getCount(), iterations * 2);
+}
+
+TEST(ModernCPPTestItem16, AdaptiveMutexStatistics)
+{
+    InstrumentedAdaptiveMutex mutex;
+    long shared = 0;
+    constexpr int numThreads = 4;
+    constexpr int iterations = 20000;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t)
+    {
+        threads.emplace_back([&]() {
+            for (int i = 0; i < iterations; ++i)
+            {
+                std::lock_guard<InstrumentedAdaptiveMutex> lock { mutex };
+                ++shared;
+            }
+        });
+    }
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    auto stats = mutex.stats();
+    EXPECT_EQ(shared, numThreads * iterations);
+    EXPECT_EQ(stats.acquisitions, static_cast<std::uint64_t>(numThreads * iterations));
+    EXPECT_LE(stats.contended, stats.acquisitions);
+    EXPECT_LE(stats.parks, stats.contended);
+    EXPECT_TRUE(mutex.try_lock());
+    EXPECT_FALSE(mutex.try_lock());
+    mutex.unlock();
+}
+
+TEST(ModernCPPTestItem16, AdaptiveMutexIsOneWord)
+{
+    EXPECT_EQ(sizeof(AdaptiveMutex), sizeof(std::uint32_t));
+}
+
+template <typename Policy>
+void expectConsistentReads()
+{
+    SyncedPair<Policy> pair { 0, 0 };
+    std::atomic<bool> done = false;
+    int tornReads = 0;
+
+    std::thread writer([&pair, &done]() {
+        for (int i = 0; i < 20000; ++i)
+        {
+            pair.write([](IntPair& p) { p = IntPair { p.getFirst() + 1, p.getSecond() + 1 }; });
+        }
+        done = true;
+    });
+    while (!done)
+    {
+        pair.read([&tornReads](const IntPair& p) {
+            if (p.getFirst() != p.getSecond())
+            {
+                ++tornReads;
+            }
+        });
+    }
+    writer.join();
+
+    EXPECT_EQ(tornReads, 0);
+    EXPECT_EQ(pair.load().getFirst(), 20000);
+}
+
+TEST(ModernCPPTestItem16, SynchronizedExclusivePolicy)
+{
+    expectConsistentReads<ExclusivePolicy>();
+}
+
+TEST(ModernCPPTestItem16, SynchronizedSharedPolicy)
+{
+    expectConsistentReads<SharedPolicy>();
+}
+
+TEST(ModernCPPTestItem16, SynchronizedSeqLockPolicy)
+{
+    expectConsistentReads<SeqLockPolicy>();
+}
+
+TEST(ModernCPPTestItem16, SynchronizedWithLockReturnsResult)
+{
+    Synchronized<std::vector<int>, SharedPolicy> values;
+
+    auto size = values.withLock([](std::vector<int>& v) {
+        v.push_back(1);
+        v.push_back(2);
+        return v.size();
+    });
+
+    EXPECT_EQ(size, 2);
+    EXPECT_EQ(values.read([](const std::vector<int>& v) { return v.back(); }), 2);
+}
+
+TEST(ModernCPPTestItem16, SynchronizedPolicyMixes)
+{
+    for (unsigned readPercent : { 50u, 95u })
+    {
+        EXPECT_EQ(readWriteThroughput<ExclusivePolicy>(4, 10'000, readPercent).tornReads, 0u);
+        EXPECT_EQ(readWriteThroughput<SharedPolicy>(4, 10'000, readPercent).tornReads, 0u);
+        EXPECT_EQ(readWriteThroughput<SeqLockPolicy>(4, 10'000, readPercent).tornReads, 0u);
+    }
+}
+
 TEST(ModernCPPTestItem17, GeneratedDefaultConstructor)
 {
     VectorWrapper vw1;
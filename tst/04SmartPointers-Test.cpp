@@ -1,5 +1,11 @@
 #include "gtest/gtest.h"
 #include <memory>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <ranges>
+#include <string>
 
 #include "04SmartPointers.h"
 
@@ -61,6 +67,54 @@ TEST(SmartPointersTestItem19, CreateTwoControlBlocksForOneObject)
     ASSERT_DEATH(doubleFreeSharedPtr(), "double free");
 }
 
+TEST(SmartPointersTestItem19, SnapshotPinOutlivesUpdate)
+{
+    Snapshot<Person> person { Person::create("Alice", 30) };
+
+    auto pin = person.load();
+    person.update([](const Person& p) { return p.withAge(31); });
+
+    EXPECT_EQ(pin->getAge(), 30);
+    EXPECT_EQ(person.load()->getAge(), 31);
+    EXPECT_EQ(person.load()->getName(), "Alice");
+}
+
+TEST(SmartPointersTestItem19, SnapshotConcurrentCopyOnWrite)
+{
+    constexpr std::size_t numWriters = 4;
+    constexpr std::size_t updatesPerWriter = 1000;
+    Snapshot<std::vector<int>> values { std::in_place };
+
+    std::vector<std::thread> writers;
+    for (std::size_t w = 0; w < numWriters; ++w)
+    {
+        writers.emplace_back([&values, w]() {
+            for (std::size_t i = 0; i < updatesPerWriter; ++i)
+            {
+                values.update([w](std::vector<int>& v) { v.push_back(static_cast<int>(w)); });
+            }
+        });
+    }
+    for (auto& t : writers)
+    {
+        t.join();
+    }
+
+    EXPECT_EQ(values.load()->size(), numWriters * updatesPerWriter);
+}
+
+TEST(SmartPointersTestItem19, SnapshotReadThroughput)
+{
+    for (std::size_t readers : { 1, 4 })
+    {
+        auto snapshot = personReadThroughput<Snapshot<Person>>(readers, 20'000);
+        auto locked = personReadThroughput<LockedSnapshot<Person>>(readers, 20'000);
+
+        EXPECT_GT(snapshot, 0.0);
+        EXPECT_GT(locked, 0.0);
+    }
+}
+
 TEST(SmartPointersItem20, LinkedListConstruction)
 {
     LinkedList<int> emptyList;
@@ -120,6 +174,342 @@ TEST(SmartPointersItem20, LinkedListErrorHandling)
     EXPECT_THROW(emptyList.pop_front(), std::runtime_error);
 }
 
+TEST(SmartPointersItem20, PooledLinkedListRecyclesNodes)
+{
+    SlabPool pool;
+    LinkedList<int, SlabAllocator<int>> pooled({ 1, 2, 3 }, SlabAllocator<int> { pool });
+
+    EXPECT_EQ(pooled, (LinkedList<int> { 1, 2, 3 }));
+    EXPECT_EQ(pool.blocksInUse(), 3);
+    auto reserved = pool.reservedBytes();
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        pooled.pop_front().push_back(i);
+    }
+    EXPECT_EQ(pool.blocksInUse(), 3);
+    EXPECT_EQ(pool.reservedBytes(), reserved);
+
+    auto copy = pooled;
+    EXPECT_EQ(copy, pooled);
+    EXPECT_EQ(pool.blocksInUse(), 6);
+
+    pooled.erase();
+    copy.erase();
+    EXPECT_EQ(pool.blocksInUse(), 0);
+}
+
+TEST(SmartPointersItem20, LongListIsDestroyedIteratively)
+{
+    LinkedList<int> list;
+    for (int i = 0; i < 1'000'000; ++i)
+    {
+        list.push_front(i);
+    }
+    LinkedList<int> other { 1 };
+    other = std::move(list);
+
+    EXPECT_FALSE(other.empty());
+    // destroying a million nodes through the chain of next pointers would overflow the stack
+}
+
+TEST(SmartPointersItem20, PooledNodesComparison)
+{
+    constexpr std::size_t numElements = 1'000'000;
+
+    auto perNode = linkedListBenchmark(numElements);
+    auto pooled = pooledLinkedListBenchmark(numElements);
+
+    // the pool skips malloc's per-block header and rounding
+    EXPECT_LT(pooled.bytesPerElement, perNode.bytesPerElement);
+}
+
+TEST(SmartPointersItem20, IndexedLinkedListMatchesVector)
+{
+    IndexedLinkedList<int> list;
+    std::vector<int> expected;
+
+    std::uint32_t state = 12345;
+    auto next = [&state](std::size_t bound) {
+        state = state * 1664525u + 1013904223u;
+        return static_cast<std::size_t>(state >> 8) % bound;
+    };
+    for (int i = 0; i < 5000; ++i)
+    {
+        if (expected.empty() || next(3) != 0)
+        {
+            auto pos = next(expected.size() + 1);
+            list.insert(i, pos);
+            expected.insert(expected.begin() + static_cast<std::ptrdiff_t>(pos), i);
+        }
+        else
+        {
+            auto pos = next(expected.size());
+            list.remove(pos);
+            expected.erase(expected.begin() + static_cast<std::ptrdiff_t>(pos));
+        }
+    }
+    list.push_front(-1).push_back(-2).pop_front().pop_back();
+
+    ASSERT_EQ(list.size(), expected.size());
+    for (std::size_t i = 0; i < expected.size(); i += 97)
+    {
+        EXPECT_EQ(list[i], expected[i]);
+    }
+    std::size_t i = 0;
+    for (auto it = list.begin(); it; ++it, ++i)
+    {
+        EXPECT_EQ(*it, expected[i]);
+    }
+
+    LinkedList<int> plain;
+    for (auto value : expected)
+    {
+        plain.push_back(value);
+    }
+    EXPECT_EQ(plain, list);
+    EXPECT_EQ(plain[expected.size() - 3], expected[expected.size() - 3]);
+}
+
+TEST(SmartPointersItem20, IndexedPositionalEditsMatchWalkedList)
+{
+    constexpr std::size_t numElements = 10'000;
+    constexpr std::size_t numEdits = 2'000;
+
+    LinkedList<int> walked;
+    IndexedLinkedList<int> indexed;
+    for (std::size_t i = 0; i < numElements; ++i)
+    {
+        walked.push_back(static_cast<int>(i));
+        indexed.push_back(static_cast<int>(i));
+    }
+    detail::positionalEdits(walked, numEdits);
+    detail::positionalEdits(indexed, numEdits);
+
+    std::vector<int> expected(walked.begin(), walked.end());
+    ASSERT_EQ(indexed.size(), expected.size());
+    for (std::size_t i = 0; i < expected.size(); ++i)
+    {
+        EXPECT_EQ(indexed[i], expected[i]) << "position " << i;
+    }
+}
+
+TEST(SmartPointersItem20, UnrolledListMatchesLinkedListApi)
+{
+    UnrolledList<int> list { 1, 2, 3 };
+    UnrolledList<int> built;
+    built.insert(1, 0).insert(3, 1).insert(2, 1);
+
+    EXPECT_EQ(built, list);
+    EXPECT_EQ(list.size(), 3);
+
+    built.remove(2).remove(1).remove(0);
+    EXPECT_TRUE(built.empty());
+    EXPECT_NE(built, list);
+
+    EXPECT_THROW(built.remove(0), std::runtime_error);
+    EXPECT_THROW(built.remove(5), std::out_of_range);
+    EXPECT_THROW(built.insert(1, 1), std::out_of_range);
+    EXPECT_THROW(built.pop_back(), std::runtime_error);
+
+    auto copy = list;
+    auto moved = std::move(list);
+    EXPECT_EQ(copy, moved);
+}
+
+TEST(SmartPointersItem20, UnrolledListSplitsAndMerges)
+{
+    UnrolledList<int> list;
+    std::vector<int> expected;
+
+    std::uint32_t state = 7;
+    auto next = [&state](std::size_t bound) {
+        state = state * 1664525u + 1013904223u;
+        return static_cast<std::size_t>(state >> 8) % bound;
+    };
+    for (int i = 0; i < 20'000; ++i)
+    {
+        if (expected.empty() || next(5) < 3)
+        {
+            auto pos = next(expected.size() + 1);
+            list.insert(i, pos);
+            expected.insert(expected.begin() + static_cast<std::ptrdiff_t>(pos), i);
+        }
+        else
+        {
+            auto pos = next(expected.size());
+            list.remove(pos);
+            expected.erase(expected.begin() + static_cast<std::ptrdiff_t>(pos));
+        }
+    }
+
+    ASSERT_EQ(list.size(), expected.size());
+    EXPECT_TRUE(std::equal(list.begin(), list.end(), expected.begin(), expected.end()));
+    EXPECT_TRUE(std::equal(std::make_reverse_iterator(list.end()), std::make_reverse_iterator(list.begin()),
+                           expected.rbegin(), expected.rend()));
+    EXPECT_EQ(list[expected.size() / 3], expected[expected.size() / 3]);
+    // merging keeps nodes from thinning out
+    EXPECT_LE(list.memoryBytes(), 8 * expected.size() * sizeof(int) + 256);
+
+    while (!list.empty())
+    {
+        list.pop_back();
+    }
+    EXPECT_EQ(list.memoryBytes(), 0);
+}
+
+TEST(SmartPointersItem20, UnrolledListThrowingCopyLeavesListIntact)
+{
+    // copying a value marked poisoned throws
+    struct Fragile
+    {
+        int value;
+        bool poisoned = false;
+
+        Fragile(int v, bool p = false) : value { v }, poisoned { p } {}
+        Fragile(const Fragile& other) : value { other.value }
+        {
+            if (other.poisoned)
+            {
+                throw std::runtime_error("copy failed");
+            }
+        }
+        Fragile& operator=(const Fragile&) = default;
+    };
+
+    UnrolledList<Fragile> list;
+    Fragile poisoned { -1, true };
+    EXPECT_THROW(list.push_back(poisoned), std::runtime_error);
+    EXPECT_THROW(list.push_front(poisoned), std::runtime_error);
+    EXPECT_TRUE(list.empty());
+    EXPECT_EQ(list.memoryBytes(), 0);
+
+    // a full node makes the next push start a new one
+    for (std::size_t i = 0; i < UnrolledList<Fragile>::Capacity; ++i)
+    {
+        list.push_back(Fragile { static_cast<int>(i) });
+    }
+    auto bytes = list.memoryBytes();
+    EXPECT_THROW(list.push_back(poisoned), std::runtime_error);
+    EXPECT_THROW(list.push_front(poisoned), std::runtime_error);
+    EXPECT_EQ(list.memoryBytes(), bytes);
+    EXPECT_EQ(list.size(), UnrolledList<Fragile>::Capacity);
+    EXPECT_EQ(std::distance(list.begin(), list.end()), static_cast<std::ptrdiff_t>(list.size()));
+}
+
+TEST(SmartPointersItem20, UnrolledListScanComparison)
+{
+    constexpr std::size_t numElements = 100'000;
+    constexpr std::size_t passes = 10;
+
+    auto linked = linkedListScanBenchmark(numElements, passes);
+    auto unrolled = unrolledListScanBenchmark(numElements, passes);
+
+    EXPECT_GT(linked.opsPerSecond, 0.0);
+    EXPECT_GT(unrolled.opsPerSecond, 0.0);
+    EXPECT_LT(unrolled.bytesPerElement, linked.bytesPerElement);
+}
+
+TEST(SmartPointersItem20, ConcurrentListIsAnOrderedSet)
+{
+    EpochDomain domain;
+    ConcurrentList<int> list { domain };
+
+    EXPECT_TRUE(list.insert(3));
+    EXPECT_TRUE(list.insert(1));
+    EXPECT_TRUE(list.insert(2));
+    EXPECT_FALSE(list.insert(2));
+    EXPECT_TRUE(list.contains(1));
+    EXPECT_FALSE(list.contains(4));
+
+    EXPECT_TRUE(list.erase(1));
+    EXPECT_FALSE(list.erase(1));
+    EXPECT_FALSE(list.contains(1));
+
+    std::vector<int> values;
+    list.forEach([&values](int value) { values.push_back(value); });
+    EXPECT_EQ(values, (std::vector<int> { 2, 3 }));
+}
+
+TEST(SmartPointersItem20, ConcurrentListUnderContention)
+{
+    constexpr int numThreads = 4;
+    constexpr int keysPerThread = 500;
+
+    EpochDomain domain;
+    {
+        ConcurrentList<int> list { domain };
+        std::vector<std::thread> threads;
+        for (int t = 0; t < numThreads; ++t)
+        {
+            // interleaved keys, so neighbouring nodes belong to different threads
+            threads.emplace_back([&list, t]() {
+                for (int round = 0; round < 3; ++round)
+                {
+                    for (int i = 0; i < keysPerThread; ++i)
+                    {
+                        EXPECT_TRUE(list.insert(i * numThreads + t));
+                    }
+                    for (int i = 0; i < keysPerThread; i += 2)
+                    {
+                        EXPECT_TRUE(list.erase(i * numThreads + t));
+                    }
+                    if (round < 2)
+                    {
+                        for (int i = 1; i < keysPerThread; i += 2)
+                        {
+                            EXPECT_TRUE(list.erase(i * numThreads + t));
+                        }
+                    }
+                }
+            });
+        }
+        for (auto& t : threads)
+        {
+            t.join();
+        }
+
+        std::vector<int> values;
+        list.forEach([&values](int value) { values.push_back(value); });
+        ASSERT_EQ(values.size(), static_cast<std::size_t>(numThreads * keysPerThread / 2));
+        EXPECT_TRUE(std::is_sorted(values.begin(), values.end()));
+        for (auto value : values)
+        {
+            EXPECT_EQ(value / numThreads % 2, 1);
+        }
+    }
+    domain.collect();
+}
+
+TEST(SmartPointersItem20, LinkedListIteratorsWorkWithRanges)
+{
+    static_assert(std::bidirectional_iterator<LinkedList<int>::iterator>);
+    static_assert(std::bidirectional_iterator<LinkedList<int>::const_iterator>);
+    static_assert(std::ranges::bidirectional_range<const IndexedLinkedList<int>>);
+    static_assert(!std::is_convertible_v<LinkedList<int>::iterator, bool>);
+
+    LinkedList<int> list { 4, 1, 3, 2 };
+
+    EXPECT_EQ(*std::ranges::find(list, 3), 3);
+    EXPECT_EQ(std::ranges::count_if(list, [](int value) { return value % 2 == 0; }), 2);
+    std::ranges::reverse(list);
+    EXPECT_EQ(list, (LinkedList<int> { 2, 3, 1, 4 }));
+
+    std::vector<int> backwards(list.rbegin(), list.rend());
+    EXPECT_EQ(backwards, (std::vector<int> { 4, 1, 3, 2 }));
+
+    LinkedList<int>::const_iterator last = std::ranges::prev(list.end());
+    EXPECT_EQ(*last, 4);
+
+    const LinkedList<std::string> names { "Alice", "Bob" };
+    std::size_t letters = 0;
+    for (auto it = names.begin(); it != names.end(); ++it)
+    {
+        letters += it->size();
+    }
+    EXPECT_EQ(letters, 8);
+}
+
 TEST(SmartPointersItem22, PimplIdiomWithUniquePtr)
 {
     std::string lValue { "lValue" };